@@ -103,43 +103,43 @@ bool Board::checkMove(Move *m, Side side) {
 }
 
 /*
- * Modifies the board to reflect the specified move.
+ * Modifies the board to reflect the specified move. Legality is worked out
+ * in the same pass as the flips: a move that flips nothing is ignored.
  */
 void Board::doMove(Move *m, Side side) {
     // A NULL move means pass.
     if (m == NULL) return;
 
-    // Ignore if move is invalid.
-    if (!checkMove(m, side)) return;
-
     int X = m->getX();
     int Y = m->getY();
+
+    // Ignore if move is invalid.
+    if (occupied(X, Y)) return;
+
     Side other = (side == BLACK) ? WHITE : BLACK;
+    bool legal = false;
     for (int dx = -1; dx <= 1; dx++) {
         for (int dy = -1; dy <= 1; dy++) {
             if (dy == 0 && dx == 0) continue;
 
-            int x = X;
-            int y = Y;
-            do {
+            int x = X + dx;
+            int y = Y + dy;
+            int n = 0;
+            while (onBoard(x, y) && get(other, x, y)) {
                 x += dx;
                 y += dy;
-            } while (onBoard(x, y) && get(other, x, y));
+                n++;
+            }
 
-            if (onBoard(x, y) && get(side, x, y)) {
-                x = X;
-                y = Y;
-                x += dx;
-                y += dy;
-                while (onBoard(x, y) && get(other, x, y)) {
-                    set(side, x, y);
-                    x += dx;
-                    y += dy;
+            if (n > 0 && onBoard(x, y) && get(side, x, y)) {
+                legal = true;
+                for (int k = 1; k <= n; k++) {
+                    set(side, X + k * dx, Y + k * dy);
                 }
             }
         }
     }
-    set(side, X, Y);
+    if (legal) set(side, X, Y);
 }
 
 /*
@@ -180,6 +180,16 @@ void Board::setBoard(char data[]) {
     }
 }
 
+/*
+ * Writes the board state into a 64 char array in the format setBoard()
+ * reads, with '-' for empty squares.
+ */
+void Board::getBoard(char data[]) {
+    for (int i = 0; i < 64; i++) {
+        data[i] = !taken[i] ? '-' : (black[i] ? 'b' : 'w');
+    }
+}
+
 /*
  * Calculates the board Heuristic score using the difference in pieces.
  */
@@ -327,9 +337,9 @@ vector<Move*> Board::possibleMoves(Side player)
     {
 	for (int j = 0; j < 8; j++) 
         {
-    	    Move *move = new Move(i, j);
-	    if (checkMove(move, player))
-		moves.push_back(move);
+    	    Move move(i, j);
+	    if (checkMove(&move, player))
+		moves.push_back(new Move(i, j));
 	}
     }
     return moves;
@@ -342,10 +352,61 @@ int Board::numMoves(Side player)
     {
 	for (int j = 0; j < 8; j++) 
         {
-    	    Move *move = new Move(i, j);
-	    if (checkMove(move, player))
+    	    Move move(i, j);
+	    if (checkMove(&move, player))
 		nmoves++;
 	}
     }
     return nmoves;
 }
+
+/*
+ * Hashes the position and side to move into a 64-bit transposition table
+ * key. Both bitboards are mixed with a multiply-xorshift finalizer.
+ */
+uint64_t Board::hashKey(Side toMove)
+{
+    uint64_t h = (uint64_t) black.to_ulong() * 0x9E3779B97F4A7C15UL;
+    h ^= (uint64_t) taken.to_ulong() + 0x632BE59BD9B4E019UL + (h << 6)
+       + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9UL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBUL;
+    h ^= h >> 31;
+    return (toMove == BLACK) ? h : ~h;
+}
+
+/*
+ * Returns the legal moves for player as a bitmask (bit x + 8 * y), worked
+ * out for all squares at once by flooding along each of the 8 directions
+ * through the opponent's discs. Allocation-free, for use in playouts.
+ */
+uint64_t Board::legalMask(Side player)
+{
+    // Shift amounts and the masks that stop a shift wrapping around a row.
+    static const int shifts[8] = { 1, -1, 8, -8, 9, -9, 7, -7 };
+    static const uint64_t wraps[8] = {
+        0xfefefefefefefefeUL, 0x7f7f7f7f7f7f7f7fUL,
+        0xffffffffffffffffUL, 0xffffffffffffffffUL,
+        0xfefefefefefefefeUL, 0x7f7f7f7f7f7f7f7fUL,
+        0x7f7f7f7f7f7f7f7fUL, 0xfefefefefefefefeUL
+    };
+
+    uint64_t blacks = black.to_ulong();
+    uint64_t all = taken.to_ulong();
+    uint64_t own = (player == BLACK) ? blacks : all & ~blacks;
+    uint64_t opp = all & ~own;
+    uint64_t moves = 0;
+
+    for (int d = 0; d < 8; d++)
+    {
+        int n = shifts[d];
+        uint64_t mask = wraps[d];
+        uint64_t run = ((n > 0) ? own << n : own >> -n) & mask & opp;
+        for (int i = 0; i < 5; i++)
+            run |= ((n > 0) ? run << n : run >> -n) & mask & opp;
+        moves |= ((n > 0) ? run << n : run >> -n) & mask;
+    }
+    return moves & ~all;
+}
@@ -3,6 +3,7 @@
 
 #include <bitset>
 #include <vector>
+#include <stdint.h>
 #include "common.h"
 using namespace std;
 
@@ -31,12 +32,16 @@ public:
     int countWhite();
 
     void setBoard(char data[]);
+    void getBoard(char data[]);
     int naiveHeuristic(Side player);
     int doHeuristic(Move *move, Side player);
 
     // list of possible moves for player
     vector<Move*> possibleMoves(Side player);
     int numMoves(Side player); // num moves possible for player
+
+    uint64_t hashKey(Side toMove); // transposition table key
+    uint64_t legalMask(Side player); // bit x + 8 * y set for each legal move
 };
 
 #endif
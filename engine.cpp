@@ -0,0 +1,59 @@
+#include "engine.h"
+
+/*
+ * Builds the shared tables. memoryKB is the total the process may use, so
+ * the arena is sized to leave headroom for everything else, including the
+ * sessions. mctsPools node pools for MCTS sessions are carved from the arena
+ * first (as many as fit) and the table gets the rest.
+ */
+Engine::Engine(int memoryKB, int mctsPools) {
+    arena = new Arena(arenaBytesForBudget(memoryKB), true);
+    numPools = 0;
+    pools = NULL;
+    poolInUse = NULL;
+    if (mctsPools > 0) {
+        poolInUse = (volatile int *) arena->alloc(mctsPools * sizeof(int), 64);
+        while (poolInUse != NULL && mctsPools > 0 && pools == NULL) {
+            pools = (MctsNode *) arena->alloc(
+                (size_t) mctsPools * MCTS_POOL_BYTES, 64);
+            if (pools == NULL) mctsPools--;
+        }
+        if (pools != NULL) numPools = mctsPools;
+    }
+    tt = new TranspositionTable(arena, arena->remaining());
+}
+
+/*
+ * Destructor for the engine. All sessions using it must be gone.
+ */
+Engine::~Engine() {
+    delete tt;
+    delete arena;
+}
+
+TranspositionTable *Engine::table() {
+    return tt;
+}
+
+Arena *Engine::memory() {
+    return arena;
+}
+
+/*
+ * Hands out a free MCTS node pool of MCTS_POOL_NODES nodes, or NULL if they
+ * are all taken. Safe to call from any thread.
+ */
+MctsNode *Engine::acquirePool() {
+    for (int i = 0; i < numPools; i++)
+        if (__sync_bool_compare_and_swap(&poolInUse[i], 0, 1))
+            return pools + (size_t) i * MCTS_POOL_NODES;
+    return NULL;
+}
+
+/*
+ * Returns a pool from acquirePool().
+ */
+void Engine::releasePool(MctsNode *pool) {
+    if (pool == NULL) return;
+    __sync_lock_release(&poolInUse[(pool - pools) / MCTS_POOL_NODES]);
+}
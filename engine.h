@@ -0,0 +1,35 @@
+#ifndef __ENGINE_H__
+#define __ENGINE_H__
+
+#include "memory.h"
+#include "ttable.h"
+#include "mcts.h"
+
+/*
+ * The part of the player that is shared by every game in the process: the
+ * memory arena and the tables carved from it. An Engine is built once and
+ * may be used by any number of Sessions on any number of threads. Apart from
+ * the transposition table, whose entries are self-validating so concurrent
+ * stores never produce a false hit, and the hand-out of MCTS node pools,
+ * nothing in it changes after construction.
+ */
+class Engine {
+
+private:
+    Arena *arena;
+    TranspositionTable *tt;
+    MctsNode *pools;
+    volatile int *poolInUse;
+    int numPools;
+
+public:
+    Engine(int memoryKB = MEMORY_BUDGET_KB, int mctsPools = 0);
+    ~Engine();
+
+    TranspositionTable *table();
+    Arena *memory();
+    MctsNode *acquirePool();
+    void releasePool(MctsNode *pool);
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "gamerec.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Fills in a header for a game that has not been played yet.
+ */
+void initRecord(RecordHeader *h, const char *black, const char *white,
+                int msPerSide) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, RECORD_MAGIC, 4);
+    h->version = RECORD_VERSION;
+    strncpy(h->black, black, sizeof(h->black));
+    strncpy(h->white, white, sizeof(h->white));
+    h->msPerSide = msPerSide;
+    h->msLeftBlack = h->msLeftWhite = msPerSide;
+}
+
+/*
+ * Bytes the record with this header takes in the file, padding included.
+ */
+size_t recordSize(const RecordHeader *h) {
+    return (sizeof(RecordHeader) + h->numMoves + 7) & ~(size_t) 7;
+}
+
+RecordWriter::RecordWriter(const char *path) {
+    f = fopen(path, "ab");
+}
+
+RecordWriter::~RecordWriter() {
+    if (f != NULL) fclose(f);
+}
+
+bool RecordWriter::ok() {
+    return f != NULL;
+}
+
+/*
+ * Appends one record; h->numMoves says how many bytes of moves there are.
+ */
+bool RecordWriter::write(const RecordHeader *h, const unsigned char *moves) {
+    static const char zeros[8] = { 0 };
+    if (f == NULL) return false;
+
+    size_t pad = recordSize(h) - sizeof(RecordHeader) - h->numMoves;
+    bool good = fwrite(h, sizeof(RecordHeader), 1, f) == 1
+             && fwrite(moves, 1, h->numMoves, f) == h->numMoves
+             && fwrite(zeros, 1, pad, f) == pad;
+    return fflush(f) == 0 && good;
+}
+
+/*
+ * Maps the whole file. An empty or missing file gives a reader with no
+ * records (ok() tells the two apart).
+ */
+RecordReader::RecordReader(const char *path) {
+    data = NULL;
+    size = 0;
+    pos = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = (const unsigned char *) p;
+            size = st.st_size;
+            madvise(p, size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+}
+
+RecordReader::~RecordReader() {
+    if (data != NULL) munmap((void *) data, size);
+}
+
+bool RecordReader::ok() {
+    return data != NULL;
+}
+
+/*
+ * Points h and moves at the next record. Returns false at the end of the
+ * file or at the first record that is truncated, not a game record, or has
+ * a move that is not a square or a pass.
+ */
+bool RecordReader::next(const RecordHeader **h, const unsigned char **moves) {
+    if (data == NULL || pos + sizeof(RecordHeader) > size) return false;
+
+    const RecordHeader *rec = (const RecordHeader *) (data + pos);
+    if (memcmp(rec->magic, RECORD_MAGIC, 4) != 0
+        || rec->version != RECORD_VERSION
+        || rec->numMoves > RECORD_MAX_MOVES
+        || pos + sizeof(RecordHeader) + rec->numMoves > size)
+        return false;
+
+    const unsigned char *m = data + pos + sizeof(RecordHeader);
+    for (int i = 0; i < rec->numMoves; i++)
+        if (m[i] > RECORD_PASS) return false;
+
+    *h = rec;
+    *moves = data + pos + sizeof(RecordHeader);
+    pos += recordSize(rec);
+    return true;
+}
+
+/*
+ * Goes back to the first record.
+ */
+void RecordReader::rewind() {
+    pos = 0;
+}
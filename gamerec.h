@@ -0,0 +1,82 @@
+#ifndef __GAMEREC_H__
+#define __GAMEREC_H__
+
+#include <cstdio>
+#include <cstddef>
+#include <stdint.h>
+using namespace std;
+
+#define RECORD_MAGIC "OGR1"
+#define RECORD_VERSION 1
+// Move byte for a pass; every other byte is a square x + 8 * y.
+#define RECORD_PASS 64
+// 60 moves with a pass before each, which no real game comes close to.
+#define RECORD_MAX_MOVES 120
+
+#define RECORD_FINISHED 1       // both sides passed
+#define RECORD_BLACK_FLAGGED 2  // black ran out of time
+#define RECORD_WHITE_FLAGGED 4  // white ran out of time
+#define RECORD_SET_POSITION 8   // moves follow a position set mid-game, so
+                                // they cannot be replayed from the start
+
+/*
+ * Game record file: records back to back, each a RecordHeader followed by
+ * numMoves move bytes (Black moves first) and zero padding up to the next
+ * multiple of 8, so every header in a mapped file is aligned and can be
+ * used in place. Multi-byte fields are in host (little-endian) order.
+ */
+struct RecordHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t numMoves;
+    uint8_t blackDiscs;     // final disc counts
+    uint8_t whiteDiscs;
+    char black[16];         // player names, NUL-padded
+    char white[16];
+    int32_t msPerSide;      // starting clock, -1 for none
+    int32_t msLeftBlack;    // clocks when the game ended, -1 for none or
+    int32_t msLeftWhite;    // unknown
+    uint32_t flags;
+};
+
+void initRecord(RecordHeader *h, const char *black, const char *white,
+                int msPerSide);
+size_t recordSize(const RecordHeader *h);
+
+/*
+ * Appends game records to a file.
+ */
+class RecordWriter {
+
+private:
+    FILE *f;
+
+public:
+    RecordWriter(const char *path);
+    ~RecordWriter();
+
+    bool ok();
+    bool write(const RecordHeader *h, const unsigned char *moves);
+};
+
+/*
+ * Walks the records of a file through a read-only mapping, handing out
+ * pointers into it rather than copies.
+ */
+class RecordReader {
+
+private:
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+
+public:
+    RecordReader(const char *path);
+    ~RecordReader();
+
+    bool ok();
+    bool next(const RecordHeader **h, const unsigned char **moves);
+    void rewind();
+};
+
+#endif
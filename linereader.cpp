@@ -0,0 +1,64 @@
+#include "linereader.h"
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+LineReader::LineReader(int fd) {
+    this->fd = fd;
+    eof = false;
+}
+
+/*
+ * Gets the next complete line. Waits up to timeoutMs for input (-1 waits
+ * forever). Returns false if no line is available in that time or the
+ * input is closed.
+ */
+bool LineReader::readLine(string *line, int timeoutMs) {
+    while (true) {
+        size_t nl = buf.find('\n');
+        if (nl != string::npos) {
+            *line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            return true;
+        }
+        if (eof) return false;
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        // A signal only interrupts the wait; it is not the end of input.
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        char chunk[4096];
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        if (n <= 0) {
+            eof = true;
+            // Treat a last unterminated line as complete.
+            if (!buf.empty()) buf += '\n';
+        } else {
+            buf.append(chunk, n);
+        }
+    }
+}
+
+/*
+ * True if a complete line can be had without reading the descriptor.
+ */
+bool LineReader::buffered() {
+    return buf.find('\n') != string::npos;
+}
+
+/*
+ * True once the other end has closed and every buffered line was read.
+ */
+bool LineReader::closed() {
+    return eof && buf.empty();
+}
+
+int LineReader::getFd() {
+    return fd;
+}
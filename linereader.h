@@ -0,0 +1,27 @@
+#ifndef __LINEREADER_H__
+#define __LINEREADER_H__
+
+#include <string>
+using namespace std;
+
+/*
+ * Line-buffered reader on a file descriptor that only blocks when asked
+ * to, so it can be polled from inside a search or an event loop.
+ */
+class LineReader {
+
+private:
+    int fd;
+    string buf;
+    bool eof;
+
+public:
+    LineReader(int fd);
+
+    bool readLine(string *line, int timeoutMs);
+    bool buffered();
+    bool closed();
+    int getFd();
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "linereader.h"
+#include "timeman.h"
+using namespace std;
+
+// Load generator for the game server: keeps a number of self-play games
+// going on one connection (each game is a Black and a White session, with
+// the answers of one relayed to the other) and reports throughput and
+// latency of the move requests.
+// usage: loadgen [-g concurrent_games] [-n total_games] [-t ms_per_side] socket
+// (-t -1 plays without a clock, at the fixed default depth)
+
+struct Game {
+    int msLeft[2];      // clock of the Black (0) and White (1) session
+    int passes;         // consecutive passes
+    double sentAt;      // when the outstanding move request was sent
+};
+
+static int sock;
+static vector<Game> games;
+static vector<double> latencies;
+
+static void sendLine(const char *fmt, int game, char side, int x, int y,
+                     int ms) {
+    char line[128];
+    int n = sprintf(line, fmt, game, side, x, y, ms);
+    if (write(sock, line, n) != n) {
+        perror("write");
+        exit(-1);
+    }
+}
+
+static void startGame(int g, int msPerSide) {
+    games[g].msLeft[0] = games[g].msLeft[1] = msPerSide;
+    games[g].passes = 0;
+    sendLine("new g%d%c Black\n", g, 'b', 0, 0, 0);
+    sendLine("new g%d%c White\n", g, 'w', 0, 0, 0);
+    games[g].sentAt = monotonicMs();
+    sendLine("move g%d%c %d %d %d\n", g, 'b', -1, -1, msPerSide);
+}
+
+static double percentile(double p) {
+    size_t i = (size_t) (p * (latencies.size() - 1));
+    return latencies[i];
+}
+
+int main(int argc, char *argv[]) {
+    int concurrent = 64, total = 256, msPerSide = 2000;
+    int opt;
+    while ((opt = getopt(argc, argv, "g:n:t:")) != -1) {
+        switch (opt) {
+        case 'g': concurrent = atoi(optarg); break;
+        case 'n': total = atoi(optarg); break;
+        case 't': msPerSide = atoi(optarg); break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1 || concurrent < 1) {
+        fprintf(stderr, "usage: %s [-g concurrent_games] [-n total_games] "
+                "[-t ms_per_side] socket\n", argv[0]);
+        exit(-1);
+    }
+    if (total < concurrent) total = concurrent;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[optind], sizeof(addr.sun_path) - 1);
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr *) &addr,
+                            sizeof(addr)) < 0) {
+        perror(argv[optind]);
+        exit(-1);
+    }
+    LineReader in(sock);
+
+    double start = monotonicMs();
+    games.resize(total);
+    int started = 0, finished = 0;
+    while (started < concurrent)
+        startGame(started++, msPerSide);
+
+    string line;
+    while (finished < total && in.readLine(&line, -1)) {
+        int g, x, y;
+        char side;
+        if (sscanf(line.c_str(), "g%d%c %d %d", &g, &side, &x, &y) != 4) {
+            if (line.find("error") != string::npos)
+                fprintf(stderr, "%s\n", line.c_str());
+            continue;
+        }
+
+        Game *game = &games[g];
+        int me = (side == 'b') ? 0 : 1;
+        double latency = monotonicMs() - game->sentAt;
+        latencies.push_back(latency);
+        if (game->msLeft[me] > 0) {
+            game->msLeft[me] -= (int) latency;
+            if (game->msLeft[me] < 1) game->msLeft[me] = 1;
+        }
+
+        game->passes = (x < 0) ? game->passes + 1 : 0;
+        if (game->passes == 2) {
+            sendLine("end g%d%c\n", g, 'b', 0, 0, 0);
+            sendLine("end g%d%c\n", g, 'w', 0, 0, 0);
+            finished++;
+            if (started < total) startGame(started++, msPerSide);
+            continue;
+        }
+
+        char next = (me == 0) ? 'w' : 'b';
+        game->sentAt = monotonicMs();
+        sendLine("move g%d%c %d %d %d\n", g, next, x, y,
+                 game->msLeft[1 - me]);
+    }
+    double elapsed = (monotonicMs() - start) / 1000.0;
+
+    if (latencies.empty()) return 1;
+    sort(latencies.begin(), latencies.end());
+    printf("%d games, %lu moves in %.2f s: %.1f moves/s\n", finished,
+           (unsigned long) latencies.size(), elapsed,
+           latencies.size() / elapsed);
+    printf("latency ms: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n",
+           percentile(0.5), percentile(0.9), percentile(0.99),
+           percentile(0.999), latencies.back());
+    return 0;
+}
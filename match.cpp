@@ -0,0 +1,204 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "engine.h"
+#include "session.h"
+#include "gamerec.h"
+#include "timeman.h"
+#include "timetrace.h"
+using namespace std;
+
+// Match runner: plays games between two players, A and B, each with its own
+// Engine, swapping colours every game. Each pair of games starts from the
+// same opening, so both players get both sides of it. A player is
+// "negamax" (the default) or "mcts", optionally followed by ":threads".
+// Moves are timed against a clock per side and running out of time loses
+// the game. Optionally writes every game to a game record file, and how
+// both players used their clocks to a time trace.
+// usage: match [-n games] [-t ms_per_side] [-o opening_plies] [-s seed]
+//              [-m memory_kb] [-r record_file] [-T trace_file]
+//              [-a player] [-b player]
+
+struct Result {
+    int wins, draws, losses;    // from A's point of view
+    int discDiff;
+};
+
+/*
+ * Parses a player name into a search mode and thread count. Returns false
+ * if it is not one.
+ */
+static bool parsePlayer(const char *name, SearchMode *mode, int *threads) {
+    *threads = 1;
+    if (strcmp(name, "negamax") == 0) {
+        *mode = SEARCH_NEGAMAX;
+        return true;
+    }
+    if (strncmp(name, "mcts", 4) != 0)
+        return false;
+    *mode = SEARCH_MCTS;
+    if (name[4] == ':')
+        *threads = atoi(name + 5);
+    return (name[4] == '\0' || name[4] == ':') && *threads >= 1
+        && *threads <= MCTS_MAX_THREADS;
+}
+
+/*
+ * Plays one game between the sessions. The first plies are random legal
+ * moves so that games between deterministic players differ. Fills in the
+ * record header and returns A's disc difference (+/-64 on time).
+ */
+static int playGame(Session *sessions[2], Side aSide, int msPerSide,
+                    int openingPlies, RecordHeader *h) {
+    int msLeft[2] = { msPerSide, msPerSide };
+    Board *board = sessions[BLACK]->getBoard();
+    Side side = BLACK;
+    int ply = 0;
+    int flagged = -1;
+
+    while (!board->isDone()) {
+        if (!board->hasMoves(side)) {
+            side = (side == BLACK) ? WHITE : BLACK;
+            continue;
+        }
+
+        Move *move;
+        if (ply < openingPlies) {
+            vector<Move*> moves = board->possibleMoves(side);
+            int pick = rand() % moves.size();
+            move = new Move(moves[pick]->x, moves[pick]->y);
+            for (unsigned int i = 0; i < moves.size(); i++)
+                delete moves[i];
+            sessions[side]->play(move, side);
+        } else {
+            // Every move is passed on as soon as it is made, so each
+            // session already has the opponent's last move.
+            double start = monotonicMs();
+            move = sessions[side]->doMove(NULL, msLeft[side]);
+            if (msLeft[side] > 0) {
+                msLeft[side] -= (int) (monotonicMs() - start);
+                if (msLeft[side] <= 0) {
+                    flagged = side;
+                    delete move;
+                    break;
+                }
+            }
+        }
+        Side other = (side == BLACK) ? WHITE : BLACK;
+        sessions[other]->play(move, side);
+        delete move;
+        side = other;
+        ply++;
+    }
+
+    sessions[BLACK]->fillRecord(h);
+    h->msLeftBlack = msLeft[BLACK];
+    h->msLeftWhite = msLeft[WHITE];
+    if (flagged == BLACK) h->flags |= RECORD_BLACK_FLAGGED;
+    if (flagged == WHITE) h->flags |= RECORD_WHITE_FLAGGED;
+
+    if (flagged >= 0) return (flagged == aSide) ? -64 : 64;
+    int diff = board->countBlack() - board->countWhite();
+    return (aSide == BLACK) ? diff : -diff;
+}
+
+int main(int argc, char *argv[]) {
+    int games = 10, msPerSide = 10000, openingPlies = 4, memoryKB = 262144;
+    unsigned int seed = 1;
+    const char *recordFile = NULL, *traceFile = NULL;
+    const char *names[2] = { "negamax", "negamax" };
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:o:s:m:r:T:a:b:")) != -1) {
+        switch (opt) {
+        case 'n': games = atoi(optarg); break;
+        case 't': msPerSide = atoi(optarg); break;
+        case 'o': openingPlies = atoi(optarg); break;
+        case 's': seed = strtoul(optarg, NULL, 10); break;
+        case 'm': memoryKB = atoi(optarg); break;
+        case 'r': recordFile = optarg; break;
+        case 'T': traceFile = optarg; break;
+        case 'a': names[0] = optarg; break;
+        case 'b': names[1] = optarg; break;
+        default: optind = argc + 1; break;
+        }
+    }
+    SearchMode modes[2];
+    int threads[2];
+    if (optind != argc || !parsePlayer(names[0], &modes[0], &threads[0])
+        || !parsePlayer(names[1], &modes[1], &threads[1])) {
+        fprintf(stderr, "usage: %s [-n games] [-t ms_per_side] "
+                "[-o opening_plies] [-s seed] [-m memory_kb] "
+                "[-r record_file] [-T trace_file] [-a player] "
+                "[-b player]\n", argv[0]);
+        exit(-1);
+    }
+
+    RecordWriter *writer = NULL;
+    if (recordFile != NULL) {
+        writer = new RecordWriter(recordFile);
+        if (!writer->ok()) {
+            perror(recordFile);
+            exit(-1);
+        }
+    }
+
+    TimeTrace *trace = NULL;
+    if (traceFile != NULL) {
+        trace = new TimeTrace(traceFile);
+        if (!trace->ok()) {
+            perror(traceFile);
+            exit(-1);
+        }
+    }
+
+    // Each player gets half of the memory budget, including a node pool if
+    // it plays MCTS.
+    Engine *a = new Engine(memoryKB / 2, modes[0] == SEARCH_MCTS);
+    Engine *b = new Engine(memoryKB / 2, modes[1] == SEARCH_MCTS);
+    Result r;
+    memset(&r, 0, sizeof(r));
+
+    for (int g = 0; g < games; g++) {
+        srand(seed + g / 2);
+        Side aSide = (g % 2 == 0) ? BLACK : WHITE;
+        Side bSide = (aSide == BLACK) ? WHITE : BLACK;
+        Session *sessions[2];
+        sessions[aSide] = new Session(a, aSide);
+        sessions[bSide] = new Session(b, bSide);
+        if (!sessions[aSide]->setSearchMode(modes[0], threads[0])
+            || !sessions[bSide]->setSearchMode(modes[1], threads[1])) {
+            fprintf(stderr, "memory budget too small for a node pool\n");
+            exit(-1);
+        }
+        sessions[BLACK]->trace = sessions[WHITE]->trace = trace;
+
+        RecordHeader h;
+        initRecord(&h, names[aSide == BLACK ? 0 : 1],
+                   names[aSide == BLACK ? 1 : 0], msPerSide);
+        int diff = playGame(sessions, aSide, msPerSide, openingPlies, &h);
+        if (writer != NULL && !writer->write(&h, sessions[BLACK]->moveList()))
+            perror(recordFile);
+
+        printf("game %d: %s %d - %d %s%s\n", g + 1, h.black, h.blackDiscs,
+               h.whiteDiscs, h.white,
+               (h.flags & RECORD_BLACK_FLAGGED) ? " (black on time)"
+               : (h.flags & RECORD_WHITE_FLAGGED) ? " (white on time)" : "");
+        if (diff > 0) r.wins++;
+        else if (diff < 0) r.losses++;
+        else r.draws++;
+        r.discDiff += diff;
+
+        delete sessions[BLACK];
+        delete sessions[WHITE];
+    }
+
+    printf("%s vs %s: +%d =%d -%d, average disc difference %+.1f\n",
+           names[0], names[1], r.wins, r.draws, r.losses,
+           (double) r.discDiff / games);
+    delete writer;
+    delete trace;
+    delete a;
+    delete b;
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include "mcts.h"
+#include <cmath>
+
+#define CORNERS 0x8100000000000081UL
+
+static uint64_t nextRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/*
+ * Index of a random set bit of a non-zero mask.
+ */
+static int randomSquare(uint64_t mask, uint64_t *rng) {
+    int k = (int) (nextRandom(rng) % __builtin_popcountl(mask));
+    while (k-- > 0) mask &= mask - 1;
+    return __builtin_ctzl(mask);
+}
+
+/*
+ * Plays random moves (a corner whenever one is legal) from the given
+ * position to the end of the game, on the board itself. Returns the final
+ * disc difference from Black's point of view.
+ */
+int playout(Board *board, Side toMove, uint64_t *rng) {
+    Side side = toMove;
+    int passes = 0;
+    while (passes < 2) {
+        uint64_t mask = board->legalMask(side);
+        if (mask == 0) {
+            passes++;
+        } else {
+            passes = 0;
+            int sq = (mask & CORNERS) ? __builtin_ctzl(mask & CORNERS)
+                                      : randomSquare(mask, rng);
+            Move move(sq % 8, sq / 8);
+            board->doMove(&move, side);
+        }
+        side = (side == BLACK) ? WHITE : BLACK;
+    }
+    return board->countBlack() - board->countWhite();
+}
+
+/*
+ * Builds a tree over a pool of capacity nodes, which the caller owns and
+ * must keep until the tree is gone.
+ */
+MctsTree::MctsTree(MctsNode *nodes, int capacity) {
+    this->nodes = nodes;
+    this->capacity = capacity;
+    used = 0;
+    numPlayouts = 0;
+    deepest = 0;
+    numHelpers = 0;
+    stopping = false;
+    rootSide = BLACK;
+}
+
+MctsTree::~MctsTree() {
+    stopHelpers();
+}
+
+/*
+ * Throws the old tree away and starts a new one at the given position.
+ */
+void MctsTree::reset(Board *board, Side toMove) {
+    root = *board;
+    rootSide = toMove;
+    used = 1;
+    numPlayouts = 0;
+    deepest = 0;
+
+    MctsNode *r = &nodes[0];
+    r->visits = r->wins = 0;
+    r->state = MCTS_LEAF;
+    r->numChildren = 0;
+    r->move = 64;
+    expand(r, &root, rootSide);
+}
+
+/*
+ * Gives a leaf its children: one per legal move, a single pass if there
+ * are none, or none at all if the game is over. Returns false if another
+ * thread got there first or the pool is full.
+ */
+bool MctsTree::expand(MctsNode *node, Board *board, Side side) {
+    uint8_t leaf = MCTS_LEAF;
+    if (!__atomic_compare_exchange_n(&node->state, &leaf, MCTS_EXPANDING,
+                                     false, __ATOMIC_ACQUIRE,
+                                     __ATOMIC_RELAXED))
+        return false;
+
+    Side other = (side == BLACK) ? WHITE : BLACK;
+    uint64_t mask = board->legalMask(side);
+    int n = __builtin_popcountl(mask);
+    if (n == 0 && board->legalMask(other) != 0) n = 1;
+
+    int32_t first = (__atomic_load_n(&used, __ATOMIC_RELAXED) + n > capacity)
+                  ? capacity : __sync_fetch_and_add(&used, n);
+    if (first + n > capacity) {
+        __atomic_store_n(&node->state, MCTS_LEAF, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    for (int i = 0; i < n; i++) {
+        MctsNode *child = &nodes[first + i];
+        child->visits = child->wins = 0;
+        child->firstChild = 0;
+        child->state = MCTS_LEAF;
+        child->numChildren = 0;
+        if (mask == 0) {
+            child->move = 64;
+        } else {
+            child->move = (uint8_t) __builtin_ctzl(mask);
+            mask &= mask - 1;
+        }
+    }
+    node->firstChild = first;
+    node->numChildren = (uint8_t) n;
+    __atomic_store_n(&node->state, MCTS_EXPANDED, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Picks the child with the best UCT score; children nobody has tried yet
+ * come first.
+ */
+int MctsTree::select(MctsNode *node) {
+    double logParent =
+        log((double) __atomic_load_n(&node->visits, __ATOMIC_RELAXED) + 1);
+    int best = node->firstChild;
+    double bestScore = -1;
+    for (int i = 0; i < node->numChildren; i++) {
+        MctsNode *child = &nodes[node->firstChild + i];
+        int32_t visits = __atomic_load_n(&child->visits, __ATOMIC_RELAXED);
+        if (visits == 0) return node->firstChild + i;
+
+        int32_t wins = __atomic_load_n(&child->wins, __ATOMIC_RELAXED);
+        double score = wins / (2.0 * visits)
+                     + MCTS_EXPLORATION * sqrt(logParent / visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = node->firstChild + i;
+        }
+    }
+    return best;
+}
+
+/*
+ * One round of the search: walk down the tree by UCT, expand the leaf
+ * reached if it has been visited often enough, play the game out at random
+ * and credit the result to every node on the path.
+ */
+void MctsTree::iterate(uint64_t *rng) {
+    Board board = root;
+    Side side = rootSide;
+    int32_t path[128];
+    Side movers[128];
+    int len = 0;
+
+    MctsNode *node = &nodes[0];
+    __sync_fetch_and_add(&node->visits, 1);
+    path[len] = 0;
+    movers[len++] = (side == BLACK) ? WHITE : BLACK;
+
+    while (len < 128) {
+        if (__atomic_load_n(&node->state, __ATOMIC_ACQUIRE)
+            != MCTS_EXPANDED) {
+            if (__atomic_load_n(&node->visits, __ATOMIC_RELAXED)
+                < MCTS_EXPAND_VISITS
+                || !expand(node, &board, side))
+                break;
+        }
+        if (node->numChildren == 0) break;
+
+        int32_t next = select(node);
+        node = &nodes[next];
+        __sync_fetch_and_add(&node->visits, 1);
+        if (node->move < 64) {
+            Move move(node->move % 8, node->move / 8);
+            board.doMove(&move, side);
+        }
+        path[len] = next;
+        movers[len++] = side;
+        side = (side == BLACK) ? WHITE : BLACK;
+    }
+    int seen = __atomic_load_n(&deepest, __ATOMIC_RELAXED);
+    while (len > seen
+           && !__atomic_compare_exchange_n(&deepest, &seen, len, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    int diff = playout(&board, side, rng);
+    for (int i = 0; i < len; i++) {
+        int won = (diff == 0) ? 1
+                : ((diff > 0) == (movers[i] == BLACK)) ? 2 : 0;
+        if (won) __sync_fetch_and_add(&nodes[path[i]].wins, won);
+    }
+    __sync_fetch_and_add(&numPlayouts, 1);
+}
+
+void *MctsTree::helperMain(void *arg) {
+    MctsTree *tree = (MctsTree *) arg;
+    uint64_t rng = (uint64_t) (size_t) &rng * 0x9E3779B97F4A7C15UL | 1;
+    while (!__atomic_load_n(&tree->stopping, __ATOMIC_RELAXED))
+        tree->iterate(&rng);
+    return NULL;
+}
+
+/*
+ * Starts n more threads searching the current tree until stopHelpers().
+ */
+void MctsTree::startHelpers(int n) {
+    __atomic_store_n(&stopping, false, __ATOMIC_RELAXED);
+    for (numHelpers = 0; numHelpers < n && numHelpers < MCTS_MAX_THREADS;
+         numHelpers++) {
+        if (pthread_create(&helpers[numHelpers], NULL, helperMain, this))
+            break;
+    }
+}
+
+void MctsTree::stopHelpers() {
+    __atomic_store_n(&stopping, true, __ATOMIC_RELAXED);
+    for (int i = 0; i < numHelpers; i++)
+        pthread_join(helpers[i], NULL);
+    numHelpers = 0;
+}
+
+/*
+ * The most visited move at the root, as a square, or 64 to pass.
+ */
+int MctsTree::bestMove() {
+    MctsNode *r = &nodes[0];
+    int best = 64;
+    int32_t most = -1;
+    for (int i = 0; i < r->numChildren; i++) {
+        MctsNode *child = &nodes[r->firstChild + i];
+        int32_t visits = __atomic_load_n(&child->visits, __ATOMIC_RELAXED);
+        if (visits > most) {
+            most = visits;
+            best = child->move;
+        }
+    }
+    return best;
+}
+
+long MctsTree::playouts() {
+    return __atomic_load_n(&numPlayouts, __ATOMIC_RELAXED);
+}
+
+/*
+ * Length of the longest path taken into the tree.
+ */
+int MctsTree::maxDepth() {
+    return __atomic_load_n(&deepest, __ATOMIC_RELAXED);
+}
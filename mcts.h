@@ -0,0 +1,86 @@
+#ifndef __MCTS_H__
+#define __MCTS_H__
+
+#include <stdint.h>
+#include <pthread.h>
+#include "common.h"
+#include "board.h"
+
+// Nodes in a session's pool (16 bytes each). Pools are carved from the
+// Engine's arena, so they come out of the same memory budget as the table.
+#define MCTS_POOL_NODES (1 << 20)
+#define MCTS_POOL_BYTES (MCTS_POOL_NODES * sizeof(MctsNode))
+// Playouts per move when there is no clock to stop the search.
+#define MCTS_DEFAULT_PLAYOUTS 20000
+// Positions with this many empty squares or fewer are left to negamax.
+#define MCTS_ENDGAME_EMPTIES 15
+// Visits a leaf needs before it is expanded.
+#define MCTS_EXPAND_VISITS 2
+// UCT exploration constant.
+#define MCTS_EXPLORATION 1.0
+#define MCTS_MAX_THREADS 64
+
+#define MCTS_LEAF 0
+#define MCTS_EXPANDING 1
+#define MCTS_EXPANDED 2
+
+/*
+ * Tree node. Statistics are only ever changed with atomic adds and read
+ * with relaxed atomic loads, so any number of threads can walk and update
+ * the tree without locks; state is published with release/acquire. A node's
+ * visits are counted on the way down, which doubles as the virtual loss
+ * that steers other threads away from the path until its result is in.
+ */
+struct MctsNode {
+    int32_t visits;
+    int32_t wins;      // 2 per win, 1 per draw, for the side that
+                                // made the move into this node
+    int32_t firstChild;         // pool index of the first child
+    uint8_t state;     // MCTS_LEAF, MCTS_EXPANDING or MCTS_EXPANDED
+    uint8_t numChildren;        // 0 once expanded means the game is over
+    uint8_t move;               // square played to get here, 64 for a pass
+    uint8_t pad;
+};
+
+/*
+ * Parallel Monte Carlo tree search (UCT) from one root position, with
+ * random playouts that take corners when they can. The node pool belongs
+ * to the caller and is fixed in size; when it is full the search carries
+ * on with playouts from the existing leaves.
+ */
+class MctsTree {
+
+private:
+    MctsNode *nodes;
+    int32_t capacity;
+    int32_t used;
+    long numPlayouts;
+    int deepest;
+    Board root;
+    Side rootSide;
+
+    pthread_t helpers[MCTS_MAX_THREADS];
+    int numHelpers;
+    bool stopping;
+
+    bool expand(MctsNode *node, Board *board, Side side);
+    int select(MctsNode *node);
+    static void *helperMain(void *tree);
+
+public:
+    MctsTree(MctsNode *nodes, int capacity);
+    ~MctsTree();
+
+    void reset(Board *board, Side toMove);
+    void iterate(uint64_t *rng);
+    void startHelpers(int n);
+    void stopHelpers();
+
+    int bestMove();
+    long playouts();
+    int maxDepth();
+};
+
+int playout(Board *board, Side toMove, uint64_t *rng);
+
+#endif
@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include "board.h"
+#include "memory.h"
+#include "mcts.h"
+#include "timeman.h"
+using namespace std;
+
+// Measures Monte Carlo search throughput: bare playouts on one thread, then
+// full tree search with 1, 2, 4, ... threads up to the given maximum, on
+// positions from random games with about 40 empty squares. Reports playouts
+// per second overall and per thread.
+// usage: mctsbench [-n positions] [-t max_threads] [-s seconds_per_position]
+
+#define BENCH_EMPTIES 40
+
+struct Position {
+    Board board;
+    Side side;
+};
+
+/*
+ * Plays random games until one reaches BENCH_EMPTIES empties with the side
+ * to move having a move.
+ */
+static Position randomPosition() {
+    for (;;) {
+        Position p;
+        p.side = BLACK;
+        while (!p.board.isDone()) {
+            int empties = 64 - p.board.countBlack() - p.board.countWhite();
+            if (empties <= BENCH_EMPTIES && p.board.hasMoves(p.side))
+                return p;
+            vector<Move*> moves = p.board.possibleMoves(p.side);
+            if (!moves.empty())
+                p.board.doMove(moves[rand() % moves.size()], p.side);
+            for (unsigned int i = 0; i < moves.size(); i++)
+                delete moves[i];
+            p.side = (p.side == BLACK) ? WHITE : BLACK;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int n = 8, maxThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    double seconds = 0.5;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:s:")) != -1) {
+        switch (opt) {
+        case 'n': n = atoi(optarg); break;
+        case 't': maxThreads = atoi(optarg); break;
+        case 's': seconds = atof(optarg); break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc || n < 1 || maxThreads < 1
+        || maxThreads > MCTS_MAX_THREADS) {
+        fprintf(stderr, "usage: %s [-n positions] [-t max_threads] "
+                "[-s seconds_per_position]\n", argv[0]);
+        exit(-1);
+    }
+
+    srand(1);
+    vector<Position> positions;
+    for (int i = 0; i < n; i++)
+        positions.push_back(randomPosition());
+
+    uint64_t rng = 0x9E3779B97F4A7C15UL;
+    long count = 0;
+    double start = monotonicMs();
+    for (int i = 0; i < n; i++) {
+        double end = monotonicMs() + seconds * 1000;
+        while (monotonicMs() < end) {
+            Board board = positions[i].board;
+            playout(&board, positions[i].side, &rng);
+            count++;
+        }
+    }
+    double elapsed = (monotonicMs() - start) / 1000;
+    printf("%d positions with %d empties, %.2f s each\n", n, BENCH_EMPTIES,
+           seconds);
+    printf("%-12s %12s %12s %8s\n", "", "playouts/s", "per thread",
+           "depth");
+    printf("%-12s %12.0f %12.0f %8s\n", "playout", count / elapsed,
+           count / elapsed, "-");
+
+    Arena arena(MCTS_POOL_BYTES, true);
+    MctsNode *pool = (MctsNode *) arena.alloc(MCTS_POOL_BYTES, 64);
+    if (pool == NULL) {
+        fprintf(stderr, "cannot map a node pool\n");
+        exit(-1);
+    }
+    MctsTree tree(pool, MCTS_POOL_NODES);
+    int next;
+    for (int threads = 1; threads <= maxThreads; threads = next) {
+        count = 0;
+        int depth = 0;
+        start = monotonicMs();
+        for (int i = 0; i < n; i++) {
+            tree.reset(&positions[i].board, positions[i].side);
+            tree.startHelpers(threads - 1);
+            double end = monotonicMs() + seconds * 1000;
+            while (monotonicMs() < end)
+                tree.iterate(&rng);
+            tree.stopHelpers();
+            count += tree.playouts();
+            depth += tree.maxDepth();
+        }
+        elapsed = (monotonicMs() - start) / 1000;
+
+        char name[32];
+        sprintf(name, "tree x%d", threads);
+        printf("%-12s %12.0f %12.0f %8.1f\n", name, count / elapsed,
+               count / elapsed / threads, (double) depth / n);
+
+        // Doubling, but always ending on maxThreads itself.
+        next = threads * 2;
+        if (threads < maxThreads && next > maxThreads) next = maxThreads;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "memory.h"
+#include <cstdio>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Reserves an arena of (at most) the given size. If the mapping cannot be
+ * made, e.g. because the address-space limit is lower than expected, the
+ * request is halved until it fits; a capacity of 0 means nothing could be
+ * mapped and every alloc() will return NULL. Pages are only committed when
+ * first touched.
+ */
+Arena::Arena(size_t bytes, bool hugePages) {
+    mapBase = NULL;
+    mapSize = 0;
+    base = NULL;
+    capacity = 0;
+    used = 0;
+    huge = false;
+
+    while (bytes >= HUGE_PAGE_SIZE) {
+        // Over-map by one huge page so the arena can start on a 2MB boundary.
+        size_t want = bytes + (hugePages ? HUGE_PAGE_SIZE : 0);
+        void *p = mmap(NULL, want, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED) {
+            mapBase = (char *) p;
+            mapSize = want;
+            break;
+        }
+        bytes /= 2;
+    }
+    if (mapBase == NULL) return;
+
+    base = mapBase;
+    capacity = bytes;
+    if (hugePages) {
+        size_t offset = (size_t) mapBase % HUGE_PAGE_SIZE;
+        if (offset != 0) base += HUGE_PAGE_SIZE - offset;
+#ifdef MADV_HUGEPAGE
+        huge = (madvise(base, capacity, MADV_HUGEPAGE) == 0);
+#endif
+    }
+#ifdef MADV_NOHUGEPAGE
+    if (!hugePages) madvise(base, capacity, MADV_NOHUGEPAGE);
+#endif
+}
+
+/*
+ * Destructor for the arena; releases the whole mapping at once.
+ */
+Arena::~Arena() {
+    if (mapBase != NULL) munmap(mapBase, mapSize);
+}
+
+/*
+ * Carves the next block of the given size and alignment (a power of two)
+ * out of the arena. Returns NULL once the arena is exhausted.
+ */
+void *Arena::alloc(size_t bytes, size_t align) {
+    size_t start = (used + align - 1) & ~(align - 1);
+    if (base == NULL || start + bytes > capacity) return NULL;
+    used = start + bytes;
+    return base + start;
+}
+
+size_t Arena::size() {
+    return capacity;
+}
+
+size_t Arena::remaining() {
+    return capacity - used;
+}
+
+/*
+ * True if the kernel accepted the huge page advice for this arena.
+ */
+bool Arena::hugePages() {
+    return huge;
+}
+
+/*
+ * Size of the arena that fits within a total budget of budgetKB, leaving
+ * MEMORY_HEADROOM_KB (or a quarter of a small budget) for everything else.
+ */
+size_t arenaBytesForBudget(size_t budgetKB) {
+    size_t headroom = MEMORY_HEADROOM_KB;
+    if (headroom > budgetKB / 4) headroom = budgetKB / 4;
+    return (budgetKB - headroom) * 1024;
+}
+
+/*
+ * Current resident set size of this process in bytes, or 0 if unknown.
+ */
+size_t residentBytes() {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return 0;
+    unsigned long pages = 0, resident = 0;
+    if (fscanf(f, "%lu %lu", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (size_t) sysconf(_SC_PAGESIZE);
+}
@@ -0,0 +1,46 @@
+#ifndef __MEMORY_H__
+#define __MEMORY_H__
+
+#include <cstddef>
+using namespace std;
+
+// Address-space limit the tournament wrapper runs us under
+// (see MAX_MEMORY_KB in java/WrapperPlayer.java).
+#define MEMORY_BUDGET_KB 786432
+
+// Part of the budget left outside the arena for code, stacks, the C++ heap
+// and the per-move Board/Move allocations made during search.
+#define MEMORY_HEADROOM_KB 65536
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/*
+ * One up-front mapping that all of the engine's large tables are carved
+ * from, so total memory use is fixed when the player is constructed and
+ * never grows during a game. Backed by transparent huge pages when the
+ * kernel allows it, which keeps TLB misses down on random hash probes.
+ */
+class Arena {
+
+private:
+    char *mapBase;
+    size_t mapSize;
+    char *base;
+    size_t capacity;
+    size_t used;
+    bool huge;
+
+public:
+    Arena(size_t bytes, bool hugePages);
+    ~Arena();
+
+    void *alloc(size_t bytes, size_t align);
+    size_t size();
+    size_t remaining();
+    bool hugePages();
+};
+
+size_t arenaBytesForBudget(size_t budgetKB);
+size_t residentBytes();
+
+#endif
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <sys/time.h>
+#include "memory.h"
+#include "ttable.h"
+#include "engine.h"
+#include "session.h"
+
+// Reports steady-state RSS and transposition table probe latency for an
+// arena of the given budget, with and without transparent huge pages, and
+// the memory taken by each game session, idle and while searching.
+// usage: memreport [budget_kb] [probes] [sessions] [ms_per_side]
+
+static double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static uint64_t nextKey(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15UL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+    return z ^ (z >> 31);
+}
+
+static void report(size_t budgetKB, long probes, bool hugePages) {
+    size_t rssBefore = residentBytes();
+    Arena *arena = new Arena(arenaBytesForBudget(budgetKB), hugePages);
+    TranspositionTable *tt = new TranspositionTable(arena, arena->remaining());
+
+    // Fill the table so every page is resident, as after a long game.
+    uint64_t state = 1;
+    long fill = (long) tt->numEntries();
+    if (fill == 0) {
+        printf("%-10s budget too small for a transposition table\n",
+               hugePages ? "huge" : "4k");
+        delete tt;
+        delete arena;
+        return;
+    }
+    for (long i = 0; i < fill; i++)
+        tt->store(nextKey(&state), (int) i, 1, BOUND_EXACT);
+    size_t rss = residentBytes() - rssBefore;
+
+    int score, depth, hits = 0;
+    Bound bound;
+    state = 1;
+    double start = now();
+    for (long i = 0; i < probes; i++) {
+        if (tt->probe(nextKey(&state), &score, &depth, &bound)) hits++;
+        if ((i + 1) % fill == 0) state = 1;
+    }
+    double elapsed = now() - start;
+
+    printf("%-10s arena %6lu MB  tt %9lu entries  rss %6lu MB  "
+           "%6.1f ns/probe  (%d hits)\n",
+           hugePages ? (arena->hugePages() ? "huge" : "huge(n/a)") : "4k",
+           (unsigned long) (arena->size() >> 20),
+           (unsigned long) tt->numEntries(), (unsigned long) (rss >> 20),
+           elapsed * 1e9 / probes, hits);
+
+    delete tt;
+    delete arena;
+}
+
+static void reportSessions(long count) {
+    Engine *engine = new Engine(16384);
+    Session **sessions = new Session*[count];
+
+    size_t rssBefore = residentBytes();
+    for (long i = 0; i < count; i++)
+        sessions[i] = new Session(engine, (i % 2) ? WHITE : BLACK);
+    size_t rss = residentBytes() - rssBefore;
+
+    printf("session    %lu bytes idle, %.0f bytes measured over %ld, "
+           "<= %lu more while searching\n",
+           (unsigned long) Session::footprintBytes(), (double) rss / count,
+           count, (unsigned long) Session::searchBytes());
+
+    for (long i = 0; i < count; i++)
+        delete sessions[i];
+    delete[] sessions;
+    delete engine;
+}
+
+/*
+ * Samples heap in use and stack depth every time the search polls it.
+ */
+class SamplingControl : public SearchControl {
+
+public:
+    size_t heapBase, heapPeak;
+    char *stackBase, *stackLow;
+
+    AbortReason poll(SearchClock *clock, int empties) {
+        char here;
+        size_t heap = mallinfo2().uordblks;
+        if (heap > heapPeak) heapPeak = heap;
+        if (&here < stackLow) stackLow = &here;
+        return ABORT_NONE;
+    }
+
+    void newPosition(Board *board) {}
+};
+
+/*
+ * Plays a timed game between two sessions and reports the most heap and
+ * stack any of their searches took, and whether the heap went back to
+ * where it was after every search. glibc counts chunks held in its thread
+ * cache as in use, so run with GLIBC_TUNABLES=glibc.malloc.tcache_count=0
+ * for exact figures.
+ */
+static void reportSearch(int msPerSide) {
+    Engine *engine = new Engine(65536);
+    Session *sessions[2];
+    sessions[BLACK] = new Session(engine, BLACK);
+    sessions[WHITE] = new Session(engine, WHITE);
+    int msLeft[2] = { msPerSide, msPerSide };
+
+    char base;
+    SamplingControl sampler;
+    sampler.heapPeak = 0;
+    sampler.stackBase = sampler.stackLow = &base;
+    sessions[BLACK]->control = sessions[WHITE]->control = &sampler;
+
+    size_t worstHeap = 0, leaked = 0;
+    int searches = 0;
+    Board *board = sessions[BLACK]->getBoard();
+    Side side = BLACK;
+    while (!board->isDone()) {
+        sampler.heapBase = sampler.heapPeak = mallinfo2().uordblks;
+        double start = now();
+        Move *move = sessions[side]->doMove(NULL, msLeft[side]);
+        msLeft[side] -= (int) ((now() - start) * 1000);
+        if (msLeft[side] < 1) msLeft[side] = 1;
+        size_t after = mallinfo2().uordblks;
+
+        // The returned move is the caller's, so it is still allocated.
+        if (after > sampler.heapBase + 32) leaked += after - sampler.heapBase;
+        if (sampler.heapPeak - sampler.heapBase > worstHeap)
+            worstHeap = sampler.heapPeak - sampler.heapBase;
+        searches++;
+
+        Side other = (side == BLACK) ? WHITE : BLACK;
+        sessions[other]->play(move, side);
+        delete move;
+        side = other;
+    }
+
+    printf("search     %d searches at %d ms per side: peak %lu bytes heap + "
+           "%lu bytes stack, %lu bytes not freed\n", searches, msPerSide,
+           (unsigned long) worstHeap,
+           (unsigned long) (sampler.stackBase - sampler.stackLow),
+           (unsigned long) leaked);
+
+    delete sessions[BLACK];
+    delete sessions[WHITE];
+    delete engine;
+}
+
+int main(int argc, char *argv[]) {
+    size_t budgetKB = (argc > 1) ? strtoul(argv[1], NULL, 10)
+                                 : MEMORY_BUDGET_KB;
+    long probes = (argc > 2) ? atol(argv[2]) : 20000000;
+    long sessions = (argc > 3) ? atol(argv[3]) : 100000;
+    int msPerSide = (argc > 4) ? atoi(argv[4]) : 10000;
+
+    printf("memory budget %lu KB\n", (unsigned long) budgetKB);
+    report(budgetKB, probes, false);
+    report(budgetKB, probes, true);
+    reportSessions(sessions);
+    reportSearch(msPerSide);
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "board.h"
+#include "engine.h"
+#include "gamerec.h"
+#include "timeman.h"
+using namespace std;
+
+// Times the Board primitives and the transposition table one at a time over
+// a set of realistic positions: every position of a game record file, or of
+// random games if none is given. Each primitive gets warmup passes and then
+// a number of timed passes over all positions; passes more than 3 median
+// absolute deviations above the median are dropped as outliers. With -p the
+// cycles, instructions and cache misses per call are read from the hardware
+// counters through perf_event_open.
+// usage: microbench [-n positions] [-r repetitions] [-p] [-m memory_kb]
+//                   [-f record_file]
+
+#define WARMUP_PASSES 2
+
+struct Position {
+    Board board;
+    Side side;          // side to move
+    Move move;          // a legal move for side, if it has one
+    Move probe;         // any square, as possibleMoves tries them all
+    bool hasMove;
+    uint64_t key;
+
+    Position() : move(0, 0), probe(0, 0) {}
+};
+
+static vector<Position> positions;
+static vector<size_t> withMove;     // positions where side has a move
+static TranspositionTable *tt;
+
+static void addPosition(Board *board, Side side) {
+    Position p;
+    p.board = *board;
+    p.side = side;
+    vector<Move*> moves = board->possibleMoves(side);
+    p.hasMove = !moves.empty();
+    if (p.hasMove) p.move = *moves[rand() % moves.size()];
+    for (unsigned int i = 0; i < moves.size(); i++)
+        delete moves[i];
+    p.probe = Move(rand() % 8, rand() % 8);
+    p.key = board->hashKey(side);
+    positions.push_back(p);
+}
+
+/*
+ * Collects every position of the games in a record file.
+ */
+static void positionsFromRecords(const char *path, size_t n) {
+    RecordReader reader(path);
+    const RecordHeader *h;
+    const unsigned char *moves;
+    while (positions.size() < n && reader.next(&h, &moves)) {
+        if (h->flags & RECORD_SET_POSITION) continue;
+        Board board;
+        Side side = BLACK;
+        for (int i = 0; i < h->numMoves && positions.size() < n; i++) {
+            addPosition(&board, side);
+            if (moves[i] != RECORD_PASS) {
+                Move move(moves[i] % 8, moves[i] / 8);
+                board.doMove(&move, side);
+            }
+            side = (side == BLACK) ? WHITE : BLACK;
+        }
+    }
+}
+
+/*
+ * Collects the positions of random games.
+ */
+static void positionsFromRandomGames(size_t n) {
+    while (positions.size() < n) {
+        Board board;
+        Side side = BLACK;
+        while (!board.isDone() && positions.size() < n) {
+            addPosition(&board, side);
+            if (positions.back().hasMove)
+                board.doMove(&positions.back().move, side);
+            side = (side == BLACK) ? WHITE : BLACK;
+        }
+    }
+}
+
+// One pass of each benchmark over all positions. The returned checksum
+// keeps the compiler from dropping the work.
+
+static long benchCheckMove() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+        sum += positions[i].board.checkMove(&positions[i].probe,
+                                            positions[i].side);
+    return sum;
+}
+
+static long benchPossibleMoves() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        vector<Move*> moves = positions[i].board.possibleMoves(
+            positions[i].side);
+        sum += moves.size();
+        for (unsigned int j = 0; j < moves.size(); j++)
+            delete moves[j];
+    }
+    return sum;
+}
+
+static long benchNumMoves() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+        sum += positions[i].board.numMoves(positions[i].side);
+    return sum;
+}
+
+static long benchDoMove() {
+    long sum = 0;
+    for (size_t k = 0; k < withMove.size(); k++) {
+        size_t i = withMove[k];
+        Board board = positions[i].board;
+        board.doMove(&positions[i].move, positions[i].side);
+        sum += board.countBlack();
+    }
+    return sum;
+}
+
+static long benchCopy() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        Board *copy = positions[i].board.copy();
+        sum += (long) (size_t) copy & 0xff;
+        delete copy;
+    }
+    return sum;
+}
+
+static long benchDoHeuristic() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+        sum += positions[i].board.doHeuristic(
+            positions[i].hasMove ? &positions[i].move : NULL,
+            positions[i].side);
+    return sum;
+}
+
+static long benchNaiveHeuristic() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+        sum += positions[i].board.naiveHeuristic(positions[i].side);
+    return sum;
+}
+
+static long benchHashKey() {
+    long sum = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+        sum += (long) positions[i].board.hashKey(positions[i].side);
+    return sum;
+}
+
+static long benchTTProbe() {
+    long sum = 0;
+    int score, depth;
+    Bound bound;
+    for (size_t i = 0; i < positions.size(); i++)
+        if (tt->probe(positions[i].key, &score, &depth, &bound))
+            sum += score;
+    return sum;
+}
+
+static long benchTTStore() {
+    for (size_t i = 0; i < positions.size(); i++)
+        tt->store(positions[i].key, (int) i, 1, BOUND_EXACT);
+    return 0;
+}
+
+/*
+ * Hardware counters for cycles, instructions and cache misses of this
+ * thread. Any counter that cannot be opened reads as unavailable.
+ */
+class PerfCounters {
+
+private:
+    int fds[3];
+
+public:
+    int64_t values[3];
+
+    PerfCounters(bool enabled) {
+        static const uint64_t configs[3] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES
+        };
+        for (int i = 0; i < 3; i++) {
+            fds[i] = -1;
+            if (!enabled) continue;
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+    }
+
+    ~PerfCounters() {
+        for (int i = 0; i < 3; i++)
+            if (fds[i] >= 0) close(fds[i]);
+    }
+
+    bool available() {
+        return fds[0] >= 0;
+    }
+
+    void start() {
+        for (int i = 0; i < 3; i++) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        for (int i = 0; i < 3; i++) {
+            values[i] = -1;
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], &values[i], sizeof(values[i]))
+                != sizeof(values[i]))
+                values[i] = -1;
+        }
+    }
+};
+
+/*
+ * Runs one benchmark, which makes calls calls per pass, and prints its line
+ * of the report; with no calls to time there is nothing to report.
+ */
+static void run(const char *name, long (*bench)(), size_t calls, int reps,
+                PerfCounters *perf) {
+    if (calls == 0) {
+        printf("%-16s %10s %10s %10s %5s\n", name, "n/a", "n/a", "n/a", "-");
+        return;
+    }
+
+    long sink = 0;
+    for (int i = 0; i < WARMUP_PASSES; i++)
+        sink += bench();
+
+    vector<double> ns;
+    double n = calls;
+    for (int i = 0; i < reps; i++) {
+        double start = monotonicMs();
+        sink += bench();
+        ns.push_back((monotonicMs() - start) * 1e6 / n);
+    }
+
+    vector<double> sorted(ns);
+    sort(sorted.begin(), sorted.end());
+    double median = sorted[sorted.size() / 2];
+    vector<double> dev;
+    for (size_t i = 0; i < sorted.size(); i++)
+        dev.push_back(sorted[i] > median ? sorted[i] - median
+                                         : median - sorted[i]);
+    sort(dev.begin(), dev.end());
+    double mad = dev[dev.size() / 2];
+
+    double total = 0;
+    int kept = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i] > median + 3 * mad && mad > 0) continue;
+        total += sorted[i];
+        kept++;
+    }
+
+    printf("%-16s %10.1f %10.1f %10.1f %5d", name, total / kept, median,
+           sorted[0], (int) sorted.size() - kept);
+
+    if (perf->available()) {
+        perf->start();
+        sink += bench();
+        perf->stop();
+        for (int i = 0; i < 3; i++) {
+            if (perf->values[i] < 0) printf(" %10s", "n/a");
+            else printf(" %10.1f", perf->values[i] / n);
+        }
+    }
+    printf("\n");
+
+    // Never true; makes the checksums observable.
+    if (sink == 0x7fffffffL) printf("%ld\n", sink);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = 20000;
+    int reps = 15, memoryKB = 262144;
+    bool usePerf = false;
+    const char *recordFile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:pm:f:")) != -1) {
+        switch (opt) {
+        case 'n': n = strtoul(optarg, NULL, 10); break;
+        case 'r': reps = atoi(optarg); break;
+        case 'p': usePerf = true; break;
+        case 'm': memoryKB = atoi(optarg); break;
+        case 'f': recordFile = optarg; break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc || n < 1 || reps < 1) {
+        fprintf(stderr, "usage: %s [-n positions] [-r repetitions] [-p] "
+                "[-m memory_kb] [-f record_file]\n", argv[0]);
+        exit(-1);
+    }
+
+    srand(1);
+    if (recordFile != NULL) positionsFromRecords(recordFile, n);
+    if (positions.empty()) positionsFromRandomGames(n);
+    for (size_t i = 0; i < positions.size(); i++)
+        if (positions[i].hasMove) withMove.push_back(i);
+
+    Engine engine(memoryKB);
+    tt = engine.table();
+
+    PerfCounters perf(usePerf);
+    printf("%lu positions from %s, %d passes each after %d warmup\n",
+           (unsigned long) positions.size(),
+           (recordFile != NULL) ? recordFile : "random games", reps,
+           WARMUP_PASSES);
+    if (usePerf && !perf.available())
+        printf("hardware counters unavailable (perf_event_open failed)\n");
+    printf("%-16s %10s %10s %10s %5s", "ns/op", "mean", "median", "min",
+           "outl");
+    if (perf.available())
+        printf(" %10s %10s %10s", "cycles", "instr", "cache-miss");
+    printf("\n");
+
+    run("checkMove", benchCheckMove, positions.size(), reps, &perf);
+    run("possibleMoves", benchPossibleMoves, positions.size(), reps, &perf);
+    run("numMoves", benchNumMoves, positions.size(), reps, &perf);
+    run("doMove", benchDoMove, withMove.size(), reps, &perf);
+    run("copy", benchCopy, positions.size(), reps, &perf);
+    run("doHeuristic", benchDoHeuristic, positions.size(), reps, &perf);
+    run("naiveHeuristic", benchNaiveHeuristic, positions.size(), reps, &perf);
+    run("hashKey", benchHashKey, positions.size(), reps, &perf);
+    // Without a table, store and probe would only time an early return.
+    size_t ttCalls = (tt->numEntries() > 0) ? positions.size() : 0;
+    run("tt store", benchTTStore, ttCalls, reps, &perf);
+    run("tt probe", benchTTProbe, ttCalls, reps, &perf);
+    return 0;
+}
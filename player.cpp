@@ -14,20 +14,23 @@
  * on (BLACK or WHITE) is passed in as "side". The constructor must finish 
  * within 30 seconds.
  */
-Player::Player(Side side) {
-    b = new Board();
+Player::Player(Side side, int memoryKB) {
     self = side;
     other = (self == BLACK) ? WHITE : BLACK;
     testingMinimax = 0;
+
+    // One game per process: a private engine with a single session.
+    engine = new Engine(memoryKB);
+    session = new Session(engine, side);
+    b = session->getBoard();
 }
 
 /*
  * Destructor for the player.
  */
 Player::~Player() {
-    for (unsigned int i = 0; i < moves_made.size(); i++)
-	delete moves_made[i];
-    delete b;
+    delete session;
+    delete engine;
 }
 
 /*
@@ -40,123 +43,20 @@ Player::~Player() {
  * be disqualified! An msLeft value of -1 indicates no time limit.
  *
  * The move returned must be legal; if there are no valid moves for your side,
- * return NULL.
+ * return NULL. The caller owns the returned move.
  */
 Move *Player::doMove(Move *opponentsMove, int msLeft) 
 {
-    b->doMove(opponentsMove, other);
-    if (b->hasMoves(self))
-    {
-	vector<Move*> moves = b->possibleMoves(self);
-
-        int score = -2000; //random negative value 
-        int new_score;
-        Move *move = moves[0];
-
-	for (unsigned int i = 0; i < moves.size(); i++)
-        {
-	    // new_score = minimax(b, moves[i], 2, self);
-	    new_score = negamax(b, moves[i], 3, self, -2000, 2000);
-	    // std::cerr << "minscore: " << new_score << endl;
-	    if (new_score > score)
-        {
-		score = new_score;
-		move = moves[i];
-	    } 
-	}
-	b->doMove(move, self);
-	// std::cerr << "Making Move: " << move->getX()
-	// 	  << ", " << move->getY() << std::endl;
-	moves_made.push_back(new Move(move->getX(), move->getY()));
-	for (unsigned int i = 0; i < moves.size(); i++)
-	{
-	    delete moves[i];
-	}
-
-	return moves_made.back();
-    }
-    else
-    {
-	return NULL;
-    }
-
+    return session->doMove(opponentsMove, msLeft);
 }
 
 /*
  * Returns negamax function result for the player
- * Adapted from minimax function
  */
 int Player::negamax(Board *to_copy, Move *to_move, int depth, Side player,
 		    int alpha, int beta)
 {
-
-    vector<Move*> moves;
-    int new_score;
-    Board *copy = to_copy->copy();
-
-    Side opp = (player == self) ? other : self;
-    //std::cerr << "Current Depth: " << depth << std::endl;
-    //std::cerr << "PLAYER: " << player << " OPP: " << opp << std::endl;
-
-    if (depth == 0)
-    {
-	    int final_score;
-	    copy->doMove(to_move, player); 
-	    final_score = copy->doHeuristic(to_move, player);
-	
-	// std::cerr << "final score: " << final_score << endl;
-	    
-        delete copy;
-        return final_score;
-    }
-
-    if (to_move != NULL)
-    {
-	// std::cerr << "PLAYER plays: " << to_move->getX() << ", "
-	//    	  << to_move->getY() << std::endl;
-	    copy->doMove(to_move, player); 
-    }
-
-    moves = copy->possibleMoves(opp);
-
-    // std::cerr << "OPP potential moves: " << std::endl;
-    // for (unsigned int i = 0; i < moves.size(); i++)
-    // 	std::cerr << moves[i]->getX() << ", "
-    // 		  << moves[i]->getY() << std::endl;
-
-    if (moves.size() == 0)
-    {
-	if (to_move == NULL)
-	    depth = 1; // end game when both sides pass
-
-	new_score = -negamax(copy, NULL, depth-1, opp, -beta, alpha);
-	if (new_score > alpha)
-	    alpha = new_score;
-	   
-	delete copy;
-	return alpha;
-    }
-
-    for (unsigned int i = 0; i < moves.size(); i++)
-    {
-	new_score = -negamax(copy, moves[i], depth-1, opp, -beta, -alpha);
-	// std::cerr << "new score: " << new_score << std::endl;
-	if (new_score > alpha)
-	{
-	    alpha = new_score;
-	    // std::cerr << "new alpha: " << new_score << std::endl;
-	}
-	if (new_score >= beta)
-	    break;
-    }
-
-    for (unsigned int i = 0; i < moves.size(); i++)
-    {
-	delete moves[i];
-    }
-
-    delete copy;
-    return alpha; 
+    return session->negamax(to_copy, to_move, depth, player, alpha, beta);
 }
 
 
@@ -4,6 +4,9 @@
 #include <iostream>
 #include "common.h"
 #include "board.h"
+#include "memory.h"
+#include "engine.h"
+#include "session.h"
 using namespace std;
 
 class Player {
@@ -11,16 +14,17 @@ class Player {
 private:
     Side self;
     Side other;
-    vector<Move*> moves_made;
+    Engine *engine;
 
 public:
-    Player(Side side);
+    Player(Side side, int memoryKB = MEMORY_BUDGET_KB);
     ~Player();
 
     Move *doMove(Move *opponentsMove, int msLeft);
 
     // Flag to tell if the player is running within the test_minimax context
     bool testingMinimax;
+    Session *session;
     Board *b;
     int negamax(Board *to_copy, Move *to_move, int depth, Side player,
 		int alpha, int beta);
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "board.h"
+#include "gamerec.h"
+#include "timeman.h"
+using namespace std;
+
+// Replays every game in a game record file through Board::doMove, straight
+// from the mapped file, checks the final position against the recorded
+// result and reports the replay rate. Games that started from a set position
+// are skipped, as they cannot be replayed from the start.
+// usage: replay [-v] [-r repeat] file
+
+static void printGame(const RecordHeader *h, const unsigned char *moves) {
+    printf("%s %d - %d %s:", h->black, h->blackDiscs, h->whiteDiscs,
+           h->white);
+    for (int i = 0; i < h->numMoves; i++) {
+        if (moves[i] == RECORD_PASS) printf(" pass");
+        else printf(" %c%d", 'a' + moves[i] % 8, 1 + moves[i] / 8);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    bool verbose = false;
+    int repeat = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "vr:")) != -1) {
+        switch (opt) {
+        case 'v': verbose = true; break;
+        case 'r': repeat = atoi(optarg); break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-v] [-r repeat] file\n", argv[0]);
+        exit(-1);
+    }
+
+    RecordReader reader(argv[optind]);
+    if (!reader.ok()) {
+        fprintf(stderr, "%s: no game records\n", argv[optind]);
+        exit(-1);
+    }
+
+    long games = 0, positions = 0, mismatches = 0;
+    const RecordHeader *h;
+    const unsigned char *moves;
+    double start = monotonicMs();
+    for (int r = 0; r < repeat; r++) {
+        reader.rewind();
+        while (reader.next(&h, &moves)) {
+            if (h->flags & RECORD_SET_POSITION) continue;
+            Board board;
+            Side side = BLACK;
+            for (int i = 0; i < h->numMoves; i++) {
+                if (moves[i] != RECORD_PASS) {
+                    Move move(moves[i] % 8, moves[i] / 8);
+                    board.doMove(&move, side);
+                    positions++;
+                }
+                side = (side == BLACK) ? WHITE : BLACK;
+            }
+            if (board.countBlack() != h->blackDiscs
+                || board.countWhite() != h->whiteDiscs)
+                mismatches++;
+            if (verbose && r == 0) printGame(h, moves);
+            games++;
+        }
+    }
+    double elapsed = (monotonicMs() - start) / 1000.0;
+
+    printf("%ld games, %ld positions in %.3f s: %.2f M positions/s",
+           games, positions, elapsed, positions / elapsed / 1e6);
+    printf(", %ld results mismatched\n", mismatches);
+    return mismatches ? 1 : 0;
+}
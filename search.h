@@ -0,0 +1,45 @@
+#ifndef __SEARCH_H__
+#define __SEARCH_H__
+
+#include "board.h"
+#include "timeman.h"
+
+// Deepest search when there is no time limit (the original fixed depth).
+#define DEFAULT_DEPTH 3
+// Deepest iteration tried when searching against the clock.
+#define MAX_SEARCH_DEPTH 60
+
+enum AbortReason {
+    ABORT_NONE,         // search ran to its maximum depth
+    ABORT_TIME,         // move budget used up
+    ABORT_STOP,         // told to stop and answer now
+    ABORT_POSITION,     // told to search a different position instead
+    ABORT_BUDGET        // stopped between iterations: the next would not fit
+};
+
+enum SearchMode {
+    SEARCH_NEGAMAX,     // iterative deepening alpha-beta
+    SEARCH_MCTS         // Monte Carlo tree search until the endgame
+};
+
+/*
+ * Control channel for a running search. The search calls poll() every
+ * SEARCH_POLL_MS while it works, so an implementation can react to outside
+ * messages (stop, clock updates, a new position) without threads.
+ */
+class SearchControl {
+
+public:
+    virtual ~SearchControl() {}
+
+    // Handles any pending messages and returns why the search should stop,
+    // or ABORT_NONE to carry on. Clock updates are applied to clock.
+    virtual AbortReason poll(SearchClock *clock, int empties) = 0;
+
+    // Called after a search returned ABORT_POSITION; sets board to the
+    // position that should be searched next. The session installs it with
+    // Session::setPosition().
+    virtual void newPosition(Board *board) = 0;
+};
+
+#endif
@@ -0,0 +1,571 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "engine.h"
+#include "session.h"
+#include "linereader.h"
+#include "gamerec.h"
+using namespace std;
+
+/*
+ * Game server: hosts any number of games on one shared Engine and searches
+ * them on a pool of worker threads. Clients talk to it over a Unix socket
+ * (or stdin/stdout when the socket is "-"), one command per line; every
+ * answer starts with the session id it is for:
+ *
+ *   new <id> Black|White      -> "<id> ok"
+ *   move <id> x y msLeft      -> "<id> x y" once searched ("-1 -1" to pass);
+ *                                x y is the opponent's move as in wrapper.cpp
+ *   stop <id>                 -> the pending move is answered now
+ *   end <id>                  -> "<id> ok"; no answers for the session
+ *                                follow it, even for a move already running
+ *
+ * Bad commands are answered with "<id> error <reason>". Sessions with work
+ * queued are served round-robin, one move at a time, so a busy game cannot
+ * starve the others. Each move is searched within the msLeft its game sent,
+ * less the time it spent queued, optionally capped by -c.
+ *
+ * When a client disconnects, every session it created is ended. On a pipe,
+ * the end of input instead lets the moves already sent be answered before
+ * the server exits.
+ *
+ * All client I/O is non-blocking. Answers are queued per connection and
+ * written from the main loop as the client takes them; a client that lets
+ * more than MAX_PENDING_OUTPUT bytes pile up is not read from until it
+ * catches up, so it can only hold up itself.
+ *
+ * With -r, every session is appended to a game record file when it ends.
+ *
+ * usage: server [-w workers] [-m memory_kb] [-c max_move_ms]
+ *               [-r record_file] socket|-
+ */
+
+// Queued answers at which a connection's commands stop being read.
+#define MAX_PENDING_OUTPUT 65536
+
+struct Connection {
+    int in;
+    int out;
+    LineReader *reader;
+    pthread_mutex_t writeLock;  // guards output
+    string output;      // answers not yet written
+    int refs;           // queued or running moves that answer here
+    bool closed;        // client went away; freed once refs drops to 0
+};
+
+/*
+ * Lets the server stop a running search on request and enforce its
+ * per-move cap.
+ */
+class ServerControl : public SearchControl {
+
+public:
+    bool stop;          // set by the main thread, read by the searching worker
+    double maxMoveMs;
+
+    ServerControl() {
+        stop = false;
+        maxMoveMs = -1;
+    }
+
+    AbortReason poll(SearchClock *clock, int empties) {
+        if (__atomic_load_n(&stop, __ATOMIC_RELAXED)) return ABORT_STOP;
+        if (maxMoveMs > 0 && clock->elapsedMs() >= maxMoveMs)
+            return ABORT_TIME;
+        return ABORT_NONE;
+    }
+
+    void newPosition(Board *board) {
+    }
+};
+
+struct Request {
+    Connection *conn;
+    int x, y, msLeft;
+    double queuedAt;    // time spent queued counts against msLeft
+};
+
+struct Game {
+    string id;
+    Connection *owner;  // the client that created the game
+    Session *session;
+    ServerControl control;
+    deque<Request> pending;
+    bool queued;        // on the ready queue
+    bool busy;          // being searched by a worker
+    bool ended;         // removed from the table; freed once idle
+    int lastMsLeft;     // our clock with the latest move request
+};
+
+// A game record copied out of an ended game, to be written without
+// holding schedLock.
+struct SavedRecord {
+    RecordHeader header;
+    unsigned char moves[RECORD_MAX_MOVES];
+};
+
+static Engine *engine;
+static double maxMoveMs = -1;
+static RecordWriter *writer;
+static pthread_mutex_t writerLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Everything below is protected by schedLock.
+static pthread_mutex_t schedLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t schedReady = PTHREAD_COND_INITIALIZER;
+static deque<Game*> ready;
+static map<string, Game*> games;
+static int inFlight;    // moves queued or being searched
+
+// Self-pipe that wakes the main loop when there is output to write.
+static int wakeFds[2];
+
+static void wake() {
+    char b = 0;
+    ssize_t n = write(wakeFds[1], &b, 1);    // full means already awake
+    (void) n;
+}
+
+/*
+ * Queues one line for a client; the main loop writes it out. Safe to call
+ * from any thread.
+ */
+static void sendLine(Connection *c, const string &line) {
+    pthread_mutex_lock(&c->writeLock);
+    c->output += line + "\n";
+    pthread_mutex_unlock(&c->writeLock);
+    wake();
+}
+
+static size_t pendingOutput(Connection *c) {
+    pthread_mutex_lock(&c->writeLock);
+    size_t n = c->output.size();
+    pthread_mutex_unlock(&c->writeLock);
+    return n;
+}
+
+/*
+ * Writes as much queued output as the client takes without blocking. If
+ * the client is gone the output is dropped.
+ */
+static void flushOutput(Connection *c) {
+    pthread_mutex_lock(&c->writeLock);
+    while (!c->output.empty()) {
+        ssize_t n = write(c->out, c->output.data(), c->output.size());
+        if (n > 0) {
+            c->output.erase(0, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                c->output.clear();
+            break;
+        }
+    }
+    pthread_mutex_unlock(&c->writeLock);
+}
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void sendReply(Connection *c, const char *id, const char *text) {
+    sendLine(c, string(id) + " " + text);
+}
+
+/*
+ * Drops a reference to a connection, freeing it if the client is gone.
+ * Called with schedLock held.
+ */
+static void release(Connection *c) {
+    if (--c->refs > 0 || !c->closed) return;
+    close(c->in);
+    if (c->out != c->in) close(c->out);
+    pthread_mutex_destroy(&c->writeLock);
+    delete c->reader;
+    delete c;
+}
+
+/*
+ * Copies out the game record for a session; the opponent is named
+ * "opponent". The server never sees the starting clock or the opponent's
+ * clock, so those are -1; ours is the one sent with the last move request.
+ */
+static void saveRecord(Game *g, SavedRecord *r) {
+    Session *s = g->session;
+    bool black = (s->getSide() == BLACK);
+    initRecord(&r->header, black ? "yanguy" : "opponent",
+               black ? "opponent" : "yanguy", -1);
+    s->fillRecord(&r->header);
+    if (black) r->header.msLeftBlack = g->lastMsLeft;
+    else r->header.msLeftWhite = g->lastMsLeft;
+    memcpy(r->moves, s->moveList(), r->header.numMoves);
+}
+
+/*
+ * Appends saved records to the record file. Called without schedLock, so
+ * the disk never holds up scheduling.
+ */
+static void writeRecords(const vector<SavedRecord> &records) {
+    if (records.empty()) return;
+    pthread_mutex_lock(&writerLock);
+    for (unsigned int i = 0; i < records.size(); i++)
+        if (!writer->write(&records[i].header, records[i].moves))
+            perror("game record");
+    pthread_mutex_unlock(&writerLock);
+}
+
+/*
+ * Frees an ended game and whatever moves were still queued for it, saving
+ * its record to records if there is a record file. Called with schedLock
+ * held.
+ */
+static void dropGame(Game *g, vector<SavedRecord> *records) {
+    if (writer != NULL) {
+        records->push_back(SavedRecord());
+        saveRecord(g, &records->back());
+    }
+    while (!g->pending.empty()) {
+        release(g->pending.front().conn);
+        g->pending.pop_front();
+        inFlight--;
+    }
+    delete g->session;
+    delete g;
+}
+
+/*
+ * Takes a game out of the table and stops its search; it is freed as soon
+ * as no worker has it. Called with schedLock held.
+ */
+static void endGame(map<string, Game*>::iterator it,
+                    vector<SavedRecord> *records) {
+    Game *g = it->second;
+    games.erase(it);
+    g->ended = true;
+    __atomic_store_n(&g->control.stop, true, __ATOMIC_RELAXED);
+    if (!g->busy && !g->queued) dropGame(g, records);
+}
+
+/*
+ * Ends every game a client created. Called with schedLock held.
+ */
+static void endGames(Connection *c, vector<SavedRecord> *records) {
+    map<string, Game*>::iterator it = games.begin();
+    while (it != games.end()) {
+        map<string, Game*>::iterator next = it;
+        ++next;
+        if (it->second->owner == c) endGame(it, records);
+        it = next;
+    }
+}
+
+/*
+ * Worker thread: takes the game at the front of the ready queue, searches
+ * one move for it and puts it at the back if it has more queued.
+ */
+static void *worker(void *arg) {
+    vector<SavedRecord> records;
+    while (true) {
+        pthread_mutex_lock(&schedLock);
+        while (ready.empty())
+            pthread_cond_wait(&schedReady, &schedLock);
+        Game *g = ready.front();
+        ready.pop_front();
+        g->queued = false;
+        if (g->ended) {
+            dropGame(g, &records);
+            pthread_mutex_unlock(&schedLock);
+            writeRecords(records);
+            records.clear();
+            continue;
+        }
+        Request req = g->pending.front();
+        g->pending.pop_front();
+        g->busy = true;
+        pthread_mutex_unlock(&schedLock);
+
+        Move *opponentsMove = NULL;
+        if (req.x >= 0 && req.y >= 0)
+            opponentsMove = new Move(req.x, req.y);
+        int msLeft = req.msLeft;
+        if (msLeft > 0) {
+            msLeft -= (int) (monotonicMs() - req.queuedAt);
+            if (msLeft < 1) msLeft = 1;
+        }
+        Move *move = g->session->doMove(opponentsMove, msLeft);
+
+        // The write lock is taken first so that an "end" answered on this
+        // connection either comes after the answer or suppresses it.
+        char text[32];
+        sprintf(text, "%d %d", move ? move->x : -1, move ? move->y : -1);
+        pthread_mutex_lock(&req.conn->writeLock);
+        pthread_mutex_lock(&schedLock);
+        bool ended = g->ended;
+        pthread_mutex_unlock(&schedLock);
+        if (!ended)
+            req.conn->output += g->id + " " + text + "\n";
+        pthread_mutex_unlock(&req.conn->writeLock);
+        delete opponentsMove;
+        delete move;
+
+        pthread_mutex_lock(&schedLock);
+        g->busy = false;
+        __atomic_store_n(&g->control.stop, false, __ATOMIC_RELAXED);
+        release(req.conn);
+        inFlight--;
+        if (g->ended) {
+            dropGame(g, &records);
+        } else if (!g->pending.empty()) {
+            g->queued = true;
+            ready.push_back(g);
+            pthread_cond_signal(&schedReady);
+        }
+        pthread_mutex_unlock(&schedLock);
+        wake();
+        writeRecords(records);
+        records.clear();
+    }
+    return NULL;
+}
+
+/*
+ * Handles one command line from a client.
+ */
+static void handle(Connection *c, const string &line) {
+    char cmd[16], id[64], side[16];
+    int x, y, msLeft;
+    if (sscanf(line.c_str(), "%15s %63s", cmd, id) != 2) {
+        if (!line.empty()) sendReply(c, "-", "error bad command");
+        return;
+    }
+
+    pthread_mutex_lock(&schedLock);
+    map<string, Game*>::iterator it = games.find(id);
+    Game *g = (it == games.end()) ? NULL : it->second;
+    const char *error = NULL;
+    vector<SavedRecord> records;
+
+    if (!strcmp(cmd, "new")) {
+        if (sscanf(line.c_str(), "new %*s %15s", side) != 1) {
+            error = "error bad command";
+        } else if (g != NULL) {
+            error = "error session exists";
+        } else {
+            g = new Game();
+            g->id = id;
+            g->owner = c;
+            g->session = new Session(engine,
+                                     strcmp(side, "Black") ? WHITE : BLACK);
+            g->control.maxMoveMs = maxMoveMs;
+            g->session->control = &g->control;
+            g->queued = g->busy = g->ended = false;
+            g->lastMsLeft = -1;
+            games[id] = g;
+        }
+    } else if (g == NULL) {
+        error = "error no such session";
+    } else if (!strcmp(cmd, "move")) {
+        if (sscanf(line.c_str(), "move %*s %d %d %d", &x, &y, &msLeft) != 3) {
+            error = "error bad command";
+        } else {
+            Request req;
+            req.conn = c;
+            req.x = x;
+            req.y = y;
+            req.msLeft = msLeft;
+            req.queuedAt = monotonicMs();
+            g->lastMsLeft = msLeft;
+            c->refs++;
+            inFlight++;
+            g->pending.push_back(req);
+            if (!g->queued && !g->busy) {
+                g->queued = true;
+                ready.push_back(g);
+                pthread_cond_signal(&schedReady);
+            }
+        }
+    } else if (!strcmp(cmd, "stop")) {
+        // Only meaningful while a move is queued or running.
+        if (g->busy || !g->pending.empty())
+            __atomic_store_n(&g->control.stop, true, __ATOMIC_RELAXED);
+    } else if (!strcmp(cmd, "end")) {
+        endGame(it, &records);
+    } else {
+        error = "error bad command";
+    }
+    pthread_mutex_unlock(&schedLock);
+    writeRecords(records);
+
+    if (error != NULL)
+        sendReply(c, id, error);
+    else if (!strcmp(cmd, "new") || !strcmp(cmd, "end"))
+        sendReply(c, id, "ok");
+}
+
+static Connection *newConnection(int in, int out) {
+    setNonBlocking(in);
+    setNonBlocking(out);
+    Connection *c = new Connection();
+    c->in = in;
+    c->out = out;
+    c->reader = new LineReader(in);
+    pthread_mutex_init(&c->writeLock, NULL);
+    c->refs = 1;        // held by the main loop until the client closes
+    c->closed = false;
+    return c;
+}
+
+static int listenOn(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+        || listen(fd, 128) < 0) {
+        perror(path);
+        exit(-1);
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    int workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int memoryKB = MEMORY_BUDGET_KB;
+    int opt;
+    const char *recordFile = NULL;
+    while ((opt = getopt(argc, argv, "w:m:c:r:")) != -1) {
+        switch (opt) {
+        case 'w': workers = atoi(optarg); break;
+        case 'm': memoryKB = atoi(optarg); break;
+        case 'c': maxMoveMs = atof(optarg); break;
+        case 'r': recordFile = optarg; break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1 || workers < 1) {
+        fprintf(stderr, "usage: %s [-w workers] [-m memory_kb] "
+                "[-c max_move_ms] [-r record_file] socket|-\n", argv[0]);
+        exit(-1);
+    }
+    if (recordFile != NULL) {
+        writer = new RecordWriter(recordFile);
+        if (!writer->ok()) {
+            perror(recordFile);
+            exit(-1);
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (pipe(wakeFds) < 0) {
+        perror("pipe");
+        exit(-1);
+    }
+    setNonBlocking(wakeFds[0]);
+    setNonBlocking(wakeFds[1]);
+
+    engine = new Engine(memoryKB);
+    for (int i = 0; i < workers; i++) {
+        pthread_t t;
+        pthread_create(&t, NULL, worker, NULL);
+        pthread_detach(t);
+    }
+
+    bool pipeMode = !strcmp(argv[optind], "-");
+    int listenFd = -1;
+    vector<Connection*> conns;
+    if (pipeMode)
+        conns.push_back(newConnection(0, 1));
+    else
+        listenFd = listenOn(argv[optind]);
+
+    while (listenFd >= 0 || !conns.empty()) {
+        // Per connection: its input, then its output. The wake pipe comes
+        // first and the listening socket last.
+        vector<struct pollfd> fds;
+        struct pollfd pfd;
+        pfd.fd = wakeFds[0];
+        pfd.events = POLLIN;
+        fds.push_back(pfd);
+        int timeout = -1;
+        for (unsigned int i = 0; i < conns.size(); i++) {
+            Connection *c = conns[i];
+            size_t pending = pendingOutput(c);
+            bool reading = pending < MAX_PENDING_OUTPUT;
+            if (reading && c->reader->buffered()) timeout = 0;
+            pfd.fd = c->in;
+            pfd.events = (reading && !c->reader->closed()) ? POLLIN : 0;
+            fds.push_back(pfd);
+            pfd.fd = c->out;
+            pfd.events = (pending > 0) ? POLLOUT : 0;
+            fds.push_back(pfd);
+        }
+        if (listenFd >= 0) {
+            pfd.fd = listenFd;
+            pfd.events = POLLIN;
+            fds.push_back(pfd);
+        }
+        if (poll(&fds[0], fds.size(), timeout) < 0) continue;
+
+        if (fds[0].revents) {
+            char drain[256];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0)
+                ;
+        }
+
+        vector<Connection*> open;
+        for (unsigned int i = 0; i < conns.size(); i++) {
+            Connection *c = conns[i];
+            if (fds[2 + 2 * i].revents)
+                flushOutput(c);
+            string line;
+            if (fds[1 + 2 * i].revents || c->reader->buffered()) {
+                while (pendingOutput(c) < MAX_PENDING_OUTPUT
+                       && c->reader->readLine(&line, 0))
+                    handle(c, line);
+            }
+            flushOutput(c);
+            if (!c->reader->closed()) {
+                open.push_back(c);
+                continue;
+            }
+
+            // On a pipe the end of input only means no more commands:
+            // stay until every move sent has been answered and written.
+            pthread_mutex_lock(&schedLock);
+            bool idle = (inFlight == 0);
+            pthread_mutex_unlock(&schedLock);
+            if (pipeMode && (!idle || pendingOutput(c) > 0)) {
+                open.push_back(c);
+                continue;
+            }
+            vector<SavedRecord> records;
+            pthread_mutex_lock(&schedLock);
+            if (!pipeMode) endGames(c, &records);
+            c->closed = true;
+            release(c);
+            pthread_mutex_unlock(&schedLock);
+            writeRecords(records);
+        }
+        conns = open;
+
+        if (listenFd >= 0 && fds.back().revents) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0) conns.push_back(newConnection(fd, fd));
+        }
+    }
+    return 0;
+}
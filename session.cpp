@@ -0,0 +1,404 @@
+#include "session.h"
+#include <cstring>
+
+/*
+ * Starts a new game on the standard board, playing the given side.
+ */
+Session::Session(Engine *engine, Side side) {
+    this->engine = engine;
+    self = side;
+    other = (self == BLACK) ? WHITE : BLACK;
+    numPlayed = 0;
+    toMove = BLACK;
+    setUp = false;
+    control = NULL;
+    trace = NULL;
+    abortReason = ABORT_NONE;
+    completedDepth = 0;
+    mode = SEARCH_NEGAMAX;
+    tree = NULL;
+    pool = NULL;
+    threads = 1;
+    rng = 0x9E3779B97F4A7C15UL ^ (uint64_t) (size_t) this;
+    memset(&lastMove, 0, sizeof(lastMove));
+}
+
+/*
+ * Destructor for the session.
+ */
+Session::~Session() {
+    delete tree;
+    engine->releasePool(pool);
+}
+
+/*
+ * Applies the opponent's move (NULL for a pass or the first move), searches
+ * for ours within msLeft (-1 for no limit) and plays it. Returns a new Move
+ * the caller must delete, or NULL if we have to pass.
+ */
+Move *Session::doMove(Move *opponentsMove, int msLeft)
+{
+    play(opponentsMove, other);
+    double start = monotonicMs();
+    clock.reset(msLeft, empties());
+
+    Move *move = search();
+    while (abortReason == ABORT_POSITION)
+    {
+	// Told to search a different position: set it up and start over
+	// with whatever is left on the clock.
+	delete move;
+	Board position;
+	control->newPosition(&position);
+	setPosition(&position, self);
+	clock.reset(clock.remainingMs(), empties());
+	move = search();
+    }
+
+    lastMove.side = self;
+    lastMove.empties = empties();
+    lastMove.msLeft = msLeft;
+    lastMove.budget = clock.budgetMs();
+    lastMove.used = monotonicMs() - start;
+    lastMove.depth = completedDepth;
+    lastMove.abort = abortReason;
+    if (trace != NULL && move != NULL)
+	trace->log(&lastMove, &board);
+
+    play(move, self);
+    return move;
+}
+
+/*
+ * Sets how the clock is shared out over the moves of this game.
+ */
+void Session::setTimePolicy(TimePolicy policy)
+{
+    clock.setPolicy(policy);
+}
+
+/*
+ * Chooses the search used for the rest of the game. MCTS runs on the given
+ * number of threads (this one included) and hands the last
+ * MCTS_ENDGAME_EMPTIES squares over to negamax. It needs a node pool from
+ * the engine; returns false, leaving the mode unchanged, if none is free.
+ */
+bool Session::setSearchMode(SearchMode mode, int threads)
+{
+    if (mode == SEARCH_MCTS && tree == NULL)
+    {
+	pool = engine->acquirePool();
+	if (pool == NULL)
+	    return false;
+	tree = new MctsTree(pool, MCTS_POOL_NODES);
+    }
+    this->mode = mode;
+    this->threads = (threads < 1) ? 1 : threads;
+    return true;
+}
+
+/*
+ * Advances the game by a move for either side. Illegal moves and passes
+ * (NULL) leave the board unchanged; a pass shows up in the history when the
+ * same side moves twice in a row.
+ */
+void Session::play(Move *m, Side side)
+{
+    if (m == NULL || !board.checkMove(m, side))
+	return;
+    board.doMove(m, side);
+    if (side != toMove && numPlayed < RECORD_MAX_MOVES)
+	history[numPlayed++] = RECORD_PASS;
+    if (numPlayed < RECORD_MAX_MOVES)
+	history[numPlayed++] = (unsigned char) (m->getX() + 8 * m->getY());
+    toMove = (side == BLACK) ? WHITE : BLACK;
+}
+
+Board *Session::getBoard()
+{
+    return &board;
+}
+
+Side Session::getSide()
+{
+    return self;
+}
+
+/*
+ * Replaces the board with a position from outside the game, with
+ * sideToMove to play next. The history restarts there and the game record
+ * is marked as not replayable from the standard start.
+ */
+void Session::setPosition(Board *position, Side sideToMove)
+{
+    board = *position;
+    numPlayed = 0;
+    toMove = sideToMove;
+    setUp = true;
+}
+
+/*
+ * Number of moves in the game so far, passes included.
+ */
+int Session::movesPlayed()
+{
+    return numPlayed;
+}
+
+/*
+ * The moves so far as game record bytes (see gamerec.h).
+ */
+const unsigned char *Session::moveList()
+{
+    return history;
+}
+
+/*
+ * Sets the moves and result of a game record from this session.
+ */
+void Session::fillRecord(RecordHeader *h)
+{
+    h->numMoves = (uint8_t) numPlayed;
+    h->blackDiscs = (uint8_t) board.countBlack();
+    h->whiteDiscs = (uint8_t) board.countWhite();
+    if (board.isDone())
+	h->flags |= RECORD_FINISHED;
+    if (setUp)
+	h->flags |= RECORD_SET_POSITION;
+}
+
+/*
+ * Bytes an idle session occupies.
+ */
+size_t Session::footprintBytes()
+{
+    return sizeof(Session);
+}
+
+/*
+ * Upper bound on the extra memory a search takes: for every ply a board
+ * copy, its move list and a stack frame, with 16 bytes of allocator
+ * overhead per block.
+ */
+size_t Session::searchBytes()
+{
+    size_t ply = (sizeof(Board) + 16)
+               + MAX_MOVES * (sizeof(Move) + 16 + sizeof(Move*)) + 16
+               + 256;
+    return (MAX_SEARCH_DEPTH + 1) * ply;
+}
+
+/*
+ * Iterative deepening negamax over the root moves, until the maximum depth
+ * is reached, the clock runs out or the control channel says stop. Returns
+ * a new copy of the best move from the deepest iteration, or NULL if there
+ * are no legal moves. abortReason tells why the search ended.
+ */
+Move *Session::search()
+{
+    abortReason = ABORT_NONE;
+    completedDepth = 0;
+    if (!board.hasMoves(self))
+	return NULL;
+    if (mode == SEARCH_MCTS && empties() > MCTS_ENDGAME_EMPTIES)
+	return mctsSearch();
+
+    vector<Move*> moves = board.possibleMoves(self);
+    Move *best = moves[0];
+
+    int max_depth = clock.limited() ? MAX_SEARCH_DEPTH : DEFAULT_DEPTH;
+    if (clock.limited() && max_depth > empties())
+	max_depth = empties();
+
+    for (int depth = 1; depth <= max_depth; depth++)
+    {
+        int score = -2000; //random negative value 
+        int new_score;
+	Move *iter_best = NULL;
+
+	for (unsigned int i = 0; i < moves.size(); i++)
+        {
+	    new_score = negamax(&board, moves[i], depth, self, -2000, 2000);
+	    if (abortReason != ABORT_NONE)
+		break;
+	    if (new_score > score)
+	    {
+		score = new_score;
+		iter_best = moves[i];
+	    } 
+	}
+
+	// The previous best move is always searched first, so even a
+	// partial iteration has compared everything it saw against it.
+	if (iter_best != NULL)
+	    best = iter_best;
+	if (abortReason != ABORT_NONE)
+	    break;
+	completedDepth = depth;
+
+	for (unsigned int i = 0; i < moves.size(); i++)
+	{
+	    if (moves[i] == best)
+	    {
+		moves[i] = moves[0];
+		moves[0] = best;
+		break;
+	    }
+	}
+
+	// The next iteration would not finish in what is left of the budget.
+	if (clock.limited() && 2 * clock.elapsedMs() > clock.budgetMs()
+	    && depth < max_depth)
+	{
+	    abortReason = ABORT_BUDGET;
+	    break;
+	}
+    }
+
+    Move *move = new Move(best->getX(), best->getY());
+    for (unsigned int i = 0; i < moves.size(); i++)
+    {
+	delete moves[i];
+    }
+    return move;
+}
+
+/*
+ * Monte Carlo tree search from the current position until the clock or the
+ * control channel stops it, or for MCTS_DEFAULT_PLAYOUTS without a clock.
+ * Helper threads share the tree while this thread polls for aborts between
+ * its own playouts. completedDepth is the deepest path into the tree.
+ */
+Move *Session::mctsSearch()
+{
+    tree->reset(&board, self);
+    tree->startHelpers(threads - 1);
+    while (!checkAbort())
+    {
+	tree->iterate(&rng);
+	if (!clock.limited() && tree->playouts() >= MCTS_DEFAULT_PLAYOUTS)
+	    break;
+    }
+    tree->stopHelpers();
+    completedDepth = tree->maxDepth();
+
+    int sq = tree->bestMove();
+    return new Move(sq % 8, sq / 8);
+}
+
+/*
+ * Called at every search node. Returns true if the search has to unwind,
+ * either because the move budget is spent or because the control channel
+ * (polled every SEARCH_POLL_MS) asked for it.
+ */
+bool Session::checkAbort()
+{
+    if (clock.expired())
+	abortReason = ABORT_TIME;
+    else if (control != NULL && clock.pollDue())
+	abortReason = control->poll(&clock, empties());
+    return abortReason != ABORT_NONE;
+}
+
+/*
+ * Number of empty squares on the current board.
+ */
+int Session::empties()
+{
+    return 64 - board.countBlack() - board.countWhite();
+}
+
+/*
+ * Returns negamax function result for the player
+ * Adapted from minimax function
+ */
+int Session::negamax(Board *to_copy, Move *to_move, int depth, Side player,
+		    int alpha, int beta)
+{
+
+    vector<Move*> moves;
+    int new_score;
+
+    if (abortReason != ABORT_NONE || checkAbort())
+	return alpha;
+
+    Board *copy = to_copy->copy();
+
+    Side opp = (player == BLACK) ? WHITE : BLACK;
+
+    if (depth == 0)
+    {
+	    int final_score;
+	    copy->doMove(to_move, player); 
+	    final_score = copy->doHeuristic(to_move, player);
+        delete copy;
+        return final_score;
+    }
+
+    int alpha_orig = alpha;
+    uint64_t key = 0;
+    if (to_move != NULL)
+    {
+	    copy->doMove(to_move, player); 
+
+	// A pass leading here can end the game, so only positions reached
+	// by a real move are cached.
+	int tt_score, tt_depth;
+	Bound tt_bound;
+	key = copy->hashKey(opp);
+	if (engine->table()->probe(key, &tt_score, &tt_depth, &tt_bound)
+	    && tt_depth >= depth)
+	{
+	    if (tt_bound == BOUND_EXACT
+		|| (tt_bound == BOUND_LOWER && tt_score >= beta)
+		|| (tt_bound == BOUND_UPPER && tt_score <= alpha))
+	    {
+		delete copy;
+		return (tt_score > alpha) ? tt_score : alpha;
+	    }
+	}
+    }
+
+    moves = copy->possibleMoves(opp);
+
+    if (moves.size() == 0)
+    {
+	if (to_move == NULL)
+	    depth = 1; // end game when both sides pass
+
+	new_score = -negamax(copy, NULL, depth-1, opp, -beta, -alpha);
+	if (new_score > alpha)
+	    alpha = new_score;
+	   
+	delete copy;
+	return alpha;
+    }
+
+    for (unsigned int i = 0; i < moves.size(); i++)
+    {
+	new_score = -negamax(copy, moves[i], depth-1, opp, -beta, -alpha);
+	if (abortReason != ABORT_NONE)
+	    break;
+	if (new_score > alpha)
+	{
+	    alpha = new_score;
+	}
+	if (new_score >= beta)
+	    break;
+    }
+
+    for (unsigned int i = 0; i < moves.size(); i++)
+    {
+	delete moves[i];
+    }
+
+    if (to_move != NULL && abortReason == ABORT_NONE)
+    {
+	Bound bound = (alpha <= alpha_orig) ? BOUND_UPPER
+	            : (alpha >= beta) ? BOUND_LOWER : BOUND_EXACT;
+	engine->table()->store(key, alpha, depth, bound);
+    }
+
+    delete copy;
+    return alpha; 
+}
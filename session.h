@@ -0,0 +1,86 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <cstddef>
+#include "common.h"
+#include "board.h"
+#include "engine.h"
+#include "search.h"
+#include "timeman.h"
+#include "gamerec.h"
+#include "timetrace.h"
+#include "mcts.h"
+using namespace std;
+
+// Most legal moves any Othello position has.
+#define MAX_MOVES 33
+
+/*
+ * One game against a shared Engine. A session holds everything that is
+ * specific to its game (board, side, move history, clock), so any number of
+ * them can be searched at once. Each session must only be used by one thread
+ * at a time, but that thread may change from call to call.
+ *
+ * An idle session takes footprintBytes() (sizeof(Session), 296 bytes on
+ * x86-64); a search additionally uses at most searchBytes() of heap and
+ * stack, which is freed when it returns (memreport measures about 3 KB of
+ * heap and 3 KB of stack over a game at 10 s per side). Choosing
+ * SEARCH_MCTS takes a 16 MB node pool from the engine's arena and puts a
+ * 576-byte MctsTree on the heap for the rest of the game.
+ */
+class Session {
+
+private:
+    Engine *engine;
+    Board board;
+    Side self;
+    Side other;
+    unsigned char history[RECORD_MAX_MOVES];  // record bytes so far
+    int numPlayed;
+    Side toMove;
+    bool setUp;         // history starts from a set position
+    SearchClock clock;
+    SearchMode mode;
+    MctsTree *tree;
+    MctsNode *pool;     // from the engine's arena; returned on destruction
+    int threads;
+    uint64_t rng;
+
+    Move *search();
+    Move *mctsSearch();
+    bool checkAbort();
+    int empties();
+
+public:
+    Session(Engine *engine, Side side);
+    ~Session();
+
+    Move *doMove(Move *opponentsMove, int msLeft);
+    void play(Move *m, Side side);
+    void setPosition(Board *position, Side sideToMove);
+    Board *getBoard();
+    Side getSide();
+    int movesPlayed();
+    const unsigned char *moveList();
+    void fillRecord(RecordHeader *h);
+
+    // Polled during search; NULL if nothing can interrupt it.
+    SearchControl *control;
+    // Why the last search ended, and the deepest iteration it completed.
+    AbortReason abortReason;
+    int completedDepth;
+    // How the last move used the clock; also logged to trace if set.
+    TraceEntry lastMove;
+    TimeTrace *trace;
+
+    void setTimePolicy(TimePolicy policy);
+    bool setSearchMode(SearchMode mode, int threads = 1);
+
+    int negamax(Board *to_copy, Move *to_move, int depth, Side player,
+		int alpha, int beta);
+
+    static size_t footprintBytes();
+    static size_t searchBytes();
+};
+
+#endif
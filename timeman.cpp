@@ -0,0 +1,134 @@
+#include "timeman.h"
+#include <ctime>
+#include <cstring>
+
+static const char *policyNames[NUM_TIME_POLICIES] = {
+    "even", "midgame", "fraction"
+};
+
+SearchClock::SearchClock() {
+    policy = TIME_EVEN;
+    reset(-1, 60);
+}
+
+/*
+ * Sets how later moves are budgeted.
+ */
+void SearchClock::setPolicy(TimePolicy policy) {
+    this->policy = policy;
+}
+
+/*
+ * Starts the clock for a new move with msLeft on the game clock.
+ */
+void SearchClock::reset(int msLeft, int empties) {
+    start = monotonicMs();
+    lastPoll = start;
+    this->msLeft = msLeft;
+    budget = allocateTime(msLeft, empties, policy);
+}
+
+/*
+ * Applies a clock update received mid-search: msLeft is the game time left
+ * as of now, so the budget is re-allocated from this point on. Updates
+ * without a positive time are ignored; an unlimited search could not be
+ * bounded again.
+ */
+void SearchClock::update(int msLeft, int empties) {
+    if (msLeft <= 0) return;
+    double elapsed = elapsedMs();
+    this->msLeft = msLeft + (int) elapsed;
+    budget = (int) elapsed + allocateTime(msLeft, empties, policy);
+}
+
+bool SearchClock::limited() {
+    return budget >= 0;
+}
+
+bool SearchClock::expired() {
+    return budget >= 0 && elapsedMs() >= budget;
+}
+
+/*
+ * True at most once every SEARCH_POLL_MS; used to rate-limit polling of
+ * the control channel.
+ */
+bool SearchClock::pollDue() {
+    double now = monotonicMs();
+    if (now - lastPoll < SEARCH_POLL_MS) return false;
+    lastPoll = now;
+    return true;
+}
+
+int SearchClock::budgetMs() {
+    return budget;
+}
+
+/*
+ * Game time left right now, or -1 if there is no limit.
+ */
+int SearchClock::remainingMs() {
+    if (msLeft <= 0) return -1;
+    int left = msLeft - (int) elapsedMs();
+    return (left > 1) ? left : 1;
+}
+
+double SearchClock::elapsedMs() {
+    return monotonicMs() - start;
+}
+
+double monotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/*
+ * Time to spend on this move given msLeft on the game clock and the number
+ * of empty squares. Keeps a reserve for wrapper overhead and shares the rest
+ * out according to the policy. Returns -1 (no limit) when msLeft is not
+ * positive.
+ */
+int allocateTime(int msLeft, int empties, TimePolicy policy) {
+    if (msLeft <= 0) return -1;
+
+    int reserve = msLeft / 20 + 20;
+    int movesLeft = (empties + 1) / 2;
+    if (movesLeft < 1) movesLeft = 1;
+
+    int budget;
+    switch (policy) {
+    case TIME_MIDGAME:
+        // Opening moves get half a share, the midgame one and a half; the
+        // endgame takes what is left.
+        budget = (msLeft - reserve) / movesLeft;
+        if (empties > 44) budget /= 2;
+        else if (empties > 20) budget += budget / 2;
+        break;
+    case TIME_FRACTION:
+        budget = (msLeft - reserve) / (movesLeft < 12 ? movesLeft : 12);
+        break;
+    default:
+        budget = (msLeft - reserve) / movesLeft;
+        break;
+    }
+    if (budget > msLeft - reserve) budget = msLeft - reserve;
+    return (budget > 1) ? budget : 1;
+}
+
+const char *timePolicyName(TimePolicy policy) {
+    return policyNames[policy];
+}
+
+/*
+ * Looks a policy up by name. Returns false if there is no such policy.
+ */
+bool parseTimePolicy(const char *name, TimePolicy *policy) {
+    for (int i = 0; i < NUM_TIME_POLICIES; i++) {
+        if (!strcmp(name, policyNames[i])) {
+            *policy = (TimePolicy) i;
+            return true;
+        }
+    }
+    return false;
+}
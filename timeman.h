@@ -0,0 +1,50 @@
+#ifndef __TIMEMAN_H__
+#define __TIMEMAN_H__
+
+// How often a running search hands control to its SearchControl.
+#define SEARCH_POLL_MS 0.1
+
+/*
+ * Ways of splitting the game clock over the moves, compared offline with the
+ * timereplay tool.
+ */
+enum TimePolicy {
+    TIME_EVEN,          // evenly over the moves still to make
+    TIME_MIDGAME,       // less in the opening, more in the midgame
+    TIME_FRACTION,      // a fixed fraction of what is left
+    NUM_TIME_POLICIES
+};
+
+/*
+ * Per-move clock. Turns the game time left (msLeft, -1 or 0 meaning no
+ * limit) into a budget for this move and tells the search when it is up.
+ */
+class SearchClock {
+
+private:
+    double start;
+    double lastPoll;
+    int msLeft;
+    int budget;
+    TimePolicy policy;
+
+public:
+    SearchClock();
+
+    void setPolicy(TimePolicy policy);
+    void reset(int msLeft, int empties);
+    void update(int msLeft, int empties);
+    bool limited();
+    bool expired();
+    bool pollDue();
+    int budgetMs();
+    int remainingMs();
+    double elapsedMs();
+};
+
+double monotonicMs();
+int allocateTime(int msLeft, int empties, TimePolicy policy = TIME_EVEN);
+const char *timePolicyName(TimePolicy policy);
+bool parseTimePolicy(const char *name, TimePolicy *policy);
+
+#endif
@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include "engine.h"
+#include "session.h"
+#include "timetrace.h"
+#include "timeman.h"
+using namespace std;
+
+// Reruns the positions of a time trace (see timetrace.h) under a simulated
+// clock, once per time policy, to compare how deep each one searches and how
+// much time it keeps in hand. Each side's clock starts from the msLeft logged
+// for its first move of a game and is charged the time every search really
+// takes. A new game starts whenever a side has more empty squares than on
+// its previous move. Untimed moves (msLeft -1) are skipped.
+// usage: timereplay [-p policy] [-m memory_kb] trace_file
+
+struct Logged {
+    TraceEntry entry;
+    char board[64];
+};
+
+struct Summary {
+    int moves, games, flagged;
+    long depthTotal;
+    int minDepth;
+    double used;
+    int minMargin;      // least time left after any move
+    long marginTotal;   // time left at the end of each side's game
+};
+
+static void printSummary(const char *name, Summary *s) {
+    printf("%-10s %6d %6d %7.2f %6d %10.0f %10d %10.0f %6d\n", name, s->moves,
+           s->games, s->moves ? (double) s->depthTotal / s->moves : 0.0,
+           s->minDepth, s->used, s->minMargin,
+           s->games ? (double) s->marginTotal / s->games : 0.0, s->flagged);
+}
+
+static void initSummary(Summary *s) {
+    s->moves = s->games = s->flagged = 0;
+    s->depthTotal = 0;
+    s->minDepth = 99;
+    s->used = 0;
+    s->minMargin = 0x7fffffff;
+    s->marginTotal = 0;
+}
+
+/*
+ * Replays the trace with a simulated clock. With policy NULL nothing is
+ * searched: the summary is of the moves as they were logged.
+ */
+static void replay(vector<Logged> &trace, TimePolicy *policy, int memoryKB,
+                   Summary *s) {
+    initSummary(s);
+    Engine *engine = (policy != NULL) ? new Engine(memoryKB) : NULL;
+    int simLeft[2] = { 0, 0 };
+    int lastEmpties[2] = { 99, 99 };
+    bool flagged[2] = { false, false };
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        TraceEntry *e = &trace[i].entry;
+        if (e->msLeft <= 0) continue;
+
+        int side = e->side;
+        if (e->empties > lastEmpties[side]) {
+            s->marginTotal += simLeft[side];
+            lastEmpties[side] = 99;
+        }
+        if (lastEmpties[side] == 99) {
+            simLeft[side] = e->msLeft;
+            flagged[side] = false;
+            s->games++;
+        }
+        lastEmpties[side] = e->empties;
+
+        int depth;
+        double used;
+        if (policy == NULL) {
+            simLeft[side] = e->msLeft;
+            depth = e->depth;
+            used = e->used;
+        } else {
+            Session session(engine, e->side);
+            session.getBoard()->setBoard(trace[i].board);
+            session.setTimePolicy(*policy);
+            delete session.doMove(NULL, simLeft[side]);
+            depth = session.lastMove.depth;
+            used = session.lastMove.used;
+        }
+
+        simLeft[side] -= (int) used;
+        if (simLeft[side] <= 0 && !flagged[side]) {
+            flagged[side] = true;
+            s->flagged++;
+        }
+        if (simLeft[side] < s->minMargin) s->minMargin = simLeft[side];
+        if (simLeft[side] < 1) simLeft[side] = 1;
+
+        s->moves++;
+        s->depthTotal += depth;
+        if (depth < s->minDepth) s->minDepth = depth;
+        s->used += used;
+    }
+    for (int side = 0; side < 2; side++)
+        if (lastEmpties[side] != 99) s->marginTotal += simLeft[side];
+    delete engine;
+}
+
+int main(int argc, char *argv[]) {
+    int memoryKB = 262144;
+    int onlyPolicy = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:m:")) != -1) {
+        TimePolicy p;
+        switch (opt) {
+        case 'p':
+            if (!parseTimePolicy(optarg, &p)) {
+                fprintf(stderr, "unknown time policy %s\n", optarg);
+                exit(-1);
+            }
+            onlyPolicy = p;
+            break;
+        case 'm': memoryKB = atoi(optarg); break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-p policy] [-m memory_kb] trace_file\n",
+                argv[0]);
+        exit(-1);
+    }
+
+    FILE *f = fopen(argv[optind], "r");
+    if (f == NULL) {
+        perror(argv[optind]);
+        exit(-1);
+    }
+    vector<Logged> trace;
+    Logged l;
+    while (readTrace(f, &l.entry, l.board))
+        trace.push_back(l);
+    fclose(f);
+
+    printf("%-10s %6s %6s %7s %6s %10s %10s %10s %6s\n", "policy", "moves",
+           "games", "depth", "min", "used ms", "min left", "avg left",
+           "flags");
+    Summary s;
+    replay(trace, NULL, memoryKB, &s);
+    printSummary("logged", &s);
+    for (int i = 0; i < NUM_TIME_POLICIES; i++) {
+        if (onlyPolicy >= 0 && i != onlyPolicy) continue;
+        TimePolicy p = (TimePolicy) i;
+        replay(trace, &p, memoryKB, &s);
+        printSummary(timePolicyName(p), &s);
+    }
+    return 0;
+}
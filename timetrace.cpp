@@ -0,0 +1,62 @@
+#include "timetrace.h"
+#include <cstring>
+
+static const char *abortNames[] = {
+    "none", "time", "stop", "position", "budget"
+};
+
+TimeTrace::TimeTrace(const char *path) {
+    f = fopen(path, "a");
+    if (f != NULL)
+        fprintf(f, "# side empties msLeft budget used depth abort board\n");
+}
+
+TimeTrace::~TimeTrace() {
+    if (f != NULL) fclose(f);
+}
+
+bool TimeTrace::ok() {
+    return f != NULL;
+}
+
+/*
+ * Writes the line for one move; board is the position that was searched.
+ */
+void TimeTrace::log(const TraceEntry *e, Board *board) {
+    if (f == NULL) return;
+
+    char data[65];
+    board->getBoard(data);
+    data[64] = '\0';
+    fprintf(f, "%c %d %d %d %.2f %d %s %s\n", (e->side == BLACK) ? 'B' : 'W',
+            e->empties, e->msLeft, e->budget, e->used, e->depth,
+            abortName(e->abort), data);
+    fflush(f);
+}
+
+/*
+ * Reads the next move from a trace file, skipping comments. Returns false
+ * at the end of the file.
+ */
+bool readTrace(FILE *f, TraceEntry *e, char board[64]) {
+    char line[256], side, abort[16], data[65];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%c %d %d %d %lf %d %15s %64s", &side, &e->empties,
+                   &e->msLeft, &e->budget, &e->used, &e->depth, abort,
+                   data) != 8 || strlen(data) != 64)
+            continue;
+
+        e->side = (side == 'B') ? BLACK : WHITE;
+        e->abort = ABORT_NONE;
+        for (int i = 0; i < 5; i++)
+            if (!strcmp(abort, abortNames[i])) e->abort = (AbortReason) i;
+        memcpy(board, data, 64);
+        return true;
+    }
+    return false;
+}
+
+const char *abortName(AbortReason abort) {
+    return abortNames[abort];
+}
@@ -0,0 +1,48 @@
+#ifndef __TIMETRACE_H__
+#define __TIMETRACE_H__
+
+#include <cstdio>
+#include "common.h"
+#include "board.h"
+#include "search.h"
+using namespace std;
+
+/*
+ * How one move used the clock.
+ */
+struct TraceEntry {
+    Side side;
+    int empties;
+    int msLeft;         // game clock the move was asked with (-1: none)
+    int budget;         // time allocated to the move (-1: no limit)
+    double used;        // time the move actually took
+    int depth;          // deepest completed iteration
+    AbortReason abort;  // why the search ended
+};
+
+/*
+ * Appends one line per move to a text file (passes are not logged, as
+ * nothing was searched):
+ *
+ *   side empties msLeft budget used depth abort board
+ *
+ * where side is B or W and board is 64 chars as Board::getBoard() writes
+ * them. Lines starting with '#' are comments.
+ */
+class TimeTrace {
+
+private:
+    FILE *f;
+
+public:
+    TimeTrace(const char *path);
+    ~TimeTrace();
+
+    bool ok();
+    void log(const TraceEntry *e, Board *board);
+};
+
+bool readTrace(FILE *f, TraceEntry *e, char board[64]);
+const char *abortName(AbortReason abort);
+
+#endif
@@ -0,0 +1,71 @@
+#include "ttable.h"
+
+/*
+ * Builds a table in the largest power-of-two number of entries that fits in
+ * the given number of bytes (capped by what is left in the arena). The
+ * arena is zero-filled, so every slot starts out empty.
+ */
+TranspositionTable::TranspositionTable(Arena *arena, size_t bytes) {
+    if (bytes > arena->remaining()) bytes = arena->remaining();
+
+    size_t n = 1;
+    while (2 * n * sizeof(TTEntry) <= bytes) n *= 2;
+
+    entries = (TTEntry *) arena->alloc(n * sizeof(TTEntry), 64);
+    mask = (entries == NULL) ? 0 : n - 1;
+}
+
+/*
+ * Destructor for the table. The entries belong to the arena.
+ */
+TranspositionTable::~TranspositionTable() {
+}
+
+/*
+ * Looks up a position. Returns true and fills in the stored result if the
+ * position is in the table; false otherwise.
+ */
+bool TranspositionTable::probe(uint64_t key, int *score, int *depth,
+                               Bound *bound) {
+    if (entries == NULL) return false;
+
+    // Other threads may store into the slot at any time. Relaxed atomics
+    // keep each word whole; key ^ data catches a slot whose two words come
+    // from different stores.
+    TTEntry *e = &entries[key & mask];
+    uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    if ((check ^ data) != key || data == 0) return false;
+
+    *score = (int) (int32_t) (data & 0xffffffffUL);
+    *depth = (int) ((data >> 32) & 0xff);
+    *bound = (Bound) ((data >> 40) & 0x3);
+    return true;
+}
+
+/*
+ * Records a result, replacing whatever was in the slot unless it holds a
+ * deeper search of the same position.
+ */
+void TranspositionTable::store(uint64_t key, int score, int depth,
+                               Bound bound) {
+    if (entries == NULL) return;
+
+    TTEntry *e = &entries[key & mask];
+    uint64_t old = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    if ((check ^ old) == key && (int) ((old >> 32) & 0xff) > depth)
+        return;
+
+    // Bit 42 marks the slot as used so an all-zero entry never matches.
+    uint64_t data = (uint64_t) (uint32_t) score
+                  | ((uint64_t) (depth & 0xff) << 32)
+                  | ((uint64_t) bound << 40)
+                  | ((uint64_t) 1 << 42);
+    __atomic_store_n(&e->check, key ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->data, data, __ATOMIC_RELAXED);
+}
+
+size_t TranspositionTable::numEntries() {
+    return (entries == NULL) ? 0 : mask + 1;
+}
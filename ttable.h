@@ -0,0 +1,35 @@
+#ifndef __TTABLE_H__
+#define __TTABLE_H__
+
+#include <stdint.h>
+#include "memory.h"
+
+enum Bound {
+    BOUND_EXACT, BOUND_LOWER, BOUND_UPPER
+};
+
+struct TTEntry {
+    uint64_t check;     // position key xor data, so torn entries never match
+    uint64_t data;      // packed score, depth and bound
+};
+
+/*
+ * Fixed-size hash table of negamax results, keyed on Board::hashKey().
+ * The table is carved from an Arena when it is built and never resized.
+ */
+class TranspositionTable {
+
+private:
+    TTEntry *entries;
+    uint64_t mask;
+
+public:
+    TranspositionTable(Arena *arena, size_t bytes);
+    ~TranspositionTable();
+
+    bool probe(uint64_t key, int *score, int *depth, Bound *bound);
+    void store(uint64_t key, int score, int depth, Bound bound);
+    size_t numEntries();
+};
+
+#endif
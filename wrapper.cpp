@@ -1,28 +1,127 @@
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <deque>
 #include "player.h"
+#include "linereader.h"
 using namespace std;
 
+/*
+ * Protocol on stdin, one command per line:
+ *
+ *   x y msLeft        opponent's move (-1 -1 for a pass) and our clock;
+ *                     answered with our move "x y" (or "-1 -1")
+ *   stop              stop the running search and answer now
+ *   time msLeft       our clock as of now, applied to the running search
+ *                     (ignored unless positive)
+ *   position <64>     replace the board (row-major, 'b'/'w', anything else
+ *                     empty); a running search restarts on it
+ *
+ * Only the first form is used by the Java wrapper. The others are read
+ * while a search runs, so an external controller gets an answer within a
+ * millisecond of asking for one.
+ *
+ * If OTHELLO_TIME_TRACE names a file, a line describing how each move used
+ * the clock is appended to it (see timetrace.h).
+ */
+
+/*
+ * Control channel that services stdin while the player is searching.
+ * Commands that are not for the running search are kept for the main loop.
+ */
+class StdinControl : public SearchControl {
+
+private:
+    LineReader *in;
+    string position;
+
+public:
+    deque<string> deferred;
+
+    StdinControl(LineReader *in) {
+        this->in = in;
+    }
+
+    AbortReason poll(SearchClock *clock, int empties) {
+        string line;
+        int ms;
+        while (in->readLine(&line, 0)) {
+            if (line == "stop") {
+                return ABORT_STOP;
+            } else if (sscanf(line.c_str(), "time %d", &ms) == 1) {
+                clock->update(ms, empties);
+            } else if (line.compare(0, 9, "position ") == 0) {
+                position = line.substr(9);
+                return ABORT_POSITION;
+            } else {
+                deferred.push_back(line);
+            }
+        }
+        return ABORT_NONE;
+    }
+
+    void newPosition(Board *board) {
+        setPosition(board, position);
+    }
+
+    static void setPosition(Board *board, string data) {
+        data.resize(64, ' ');
+        board->setBoard(&data[0]);
+    }
+};
+
 int main(int argc, char *argv[]) {    
     // Read in side the player is on.
-    if (argc != 2)  {
-        cerr << "usage: " << argv[0] << " side" << endl;
+    if (argc != 2 && argc != 3)  {
+        cerr << "usage: " << argv[0] << " side [memory_kb]" << endl;
         exit(-1);
     }
     Side side = (!strcmp(argv[1], "Black")) ? BLACK : WHITE;
+    int memoryKB = (argc == 3) ? atoi(argv[2]) : MEMORY_BUDGET_KB;
 
     // Initialize player.
-    Player *player = new Player(side);
+    Player *player = new Player(side, memoryKB);
+    // Log how each move used the clock if asked to.
+    TimeTrace *trace = NULL;
+    if (getenv("OTHELLO_TIME_TRACE") != NULL) {
+        trace = new TimeTrace(getenv("OTHELLO_TIME_TRACE"));
+        player->session->trace = trace;
+    }
+
+    LineReader in(0);
+    StdinControl control(&in);
+    player->session->control = &control;
 
     // Tell java wrapper that we are done initializing.
     cout << "Init done" << endl;
     cout.flush();    
     
     int moveX, moveY, msLeft;    
+    string line;
 
     // Get opponent's move and time left for player each turn.
-    while (cin >> moveX >> moveY >> msLeft) {
+    while (true) {
+        if (!control.deferred.empty()) {
+            line = control.deferred.front();
+            control.deferred.pop_front();
+        } else if (!in.readLine(&line, -1)) {
+            break;
+        }
+
+        // Nothing is searching, so stop and time updates have no effect.
+        // A position set now is followed by the opponent's move.
+        if (line.compare(0, 9, "position ") == 0) {
+            Board position;
+            StdinControl::setPosition(&position, line.substr(9));
+            player->session->setPosition(&position,
+                                         (side == BLACK) ? WHITE : BLACK);
+            continue;
+        }
+        if (sscanf(line.c_str(), "%d %d %d", &moveX, &moveY, &msLeft) != 3)
+            continue;
+
         Move *opponentsMove = NULL;
         if (moveX >= 0 && moveY >= 0) {
             opponentsMove = new Move(moveX, moveY);